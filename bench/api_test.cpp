@@ -0,0 +1,257 @@
+/**
+ * @file bench/api_test.cpp
+ *
+ * @brief Checks of the libns1d0 interface (include/ns1d0_api.h), linked against lib/libns1d0.a.
+ *
+ * @section Overview
+ *
+ * Run by `make test-api`. Each check prints one line and the program exits
+ * non-zero if any of them failed:
+ *
+ *   - callback:  for every n in bench/golden.txt, ns1d0_search() hands over
+ *                exactly the golden sequences: same count, and the same hash of
+ *                the sorted lines bin/sequence would have written,
+ *   - generator: NS1D0Generator yields the same sequences, one at a time,
+ *   - limit:     the search stops after exactly limit sequences,
+ *   - callback returning false, and the cancel flag set mid-search: the search
+ *                stops early and reports itself incomplete,
+ *   - early destruction: a generator destroyed long before it is drained, with
+ *                its workers blocked on a full channel, returns promptly.
+ *
+ * Usage: api_test [golden file]
+ *        (default: bench/golden.txt)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/ns1d0_api.h"
+
+/**
+ * @struct Golden
+ *
+ * @brief The expected output for one n.
+ *
+ * @var sequences Number of sequences.
+ * @var hash FNV-1a 64 of the output's lines, sorted bytewise, each followed by a newline.
+ */
+struct Golden {
+    std::size_t sequences = 0;
+    std::uint64_t hash = 0;
+};
+
+/**
+ * @brief Load the golden file: one "n sequences hash" line per n; # starts a comment.
+ */
+static bool load_golden(const std::string& path, std::map<int, Golden>& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        int n;
+        Golden g;
+        std::string hash;
+        if (fields >> n >> g.sequences >> hash) {
+            g.hash = std::strtoull(hash.c_str(), nullptr, 16);
+            out[n] = g;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief A sequence as bin/sequence writes it on one line of a text file.
+ */
+static std::string text_line(const int* seq, std::size_t size) {
+    std::string line;
+    for (std::size_t i = 0; i < size; i++) {
+        line += (i ? ", " : "") + std::to_string(seq[i]);
+    }
+    return line;
+}
+
+/**
+ * @brief Count and hash output lines the way bench/golden.txt does.
+ */
+static Golden hash_lines(std::vector<std::string>& lines) {
+    std::sort(lines.begin(), lines.end());
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](char c) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    };
+    for (const std::string& l : lines) {
+        for (char c : l) add(c);
+        add('\n');
+    }
+    return Golden{lines.size(), hash};
+}
+
+static int failures = 0;
+
+/**
+ * @brief Print the outcome of one check and remember a failure.
+ *
+ * @param ok Whether the check passed.
+ * @param what What was checked.
+ *
+ * @return void
+ */
+static void report(bool ok, const std::string& what) {
+    std::cout << (ok ? "OK      " : "FAILED  ") << what << std::endl;
+    if (!ok) {
+        ++failures;
+    }
+}
+
+/**
+ * @brief Whether seq is a sequence of NS1D0(n) as far as its shape goes: the right length, 0 first, elements below n.
+ */
+static bool well_formed(int n, const int* seq, std::size_t size) {
+    if (size != static_cast<std::size_t>(ns1d0_config(n).targetLength) || seq[0] != 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < size; i++) {
+        if (seq[i] < 0 || seq[i] >= n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Seconds elapsed since start.
+ */
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    const std::string goldenPath = argc > 1 ? argv[1] : "bench/golden.txt";
+    std::map<int, Golden> golden;
+    if (!load_golden(goldenPath, golden) || golden.empty()) {
+        std::cerr << "Error: Could not read " << goldenPath << "." << std::endl;
+        return 1;
+    }
+
+    // Every sequence reaches the callback exactly once
+    for (const auto& [n, expected] : golden) {
+        std::mutex mtx;
+        std::vector<std::string> lines;
+        std::atomic<bool> malformed{false};
+        const NS1D0SearchResult r = ns1d0_search(n, {}, [&](SequenceView seq) {
+            if (!well_formed(n, seq.data, seq.size)) {
+                malformed.store(true);
+            }
+            std::string line = text_line(seq.data, seq.size);
+            std::lock_guard<std::mutex> lock(mtx);
+            lines.push_back(std::move(line));
+            return true;
+        });
+        const Golden got = hash_lines(lines);
+        report(got.sequences == expected.sequences && got.hash == expected.hash && r.sequences == expected.sequences &&
+                   r.complete && !malformed.load(),
+               "callback, n = " + std::to_string(n) + ": " + std::to_string(got.sequences) + " sequences, expected " +
+                   std::to_string(expected.sequences) + (got.hash == expected.hash ? ", hash matches" : ", hash differs"));
+    }
+
+    // The generator yields the same sequences one at a time
+    for (const auto& [n, expected] : golden) {
+        NS1D0Generator gen(n, {}, 16);
+        std::vector<std::string> lines;
+        bool malformed = false;
+        for (const std::vector<int>& seq : gen) {
+            malformed = malformed || !well_formed(n, seq.data(), seq.size());
+            lines.push_back(text_line(seq.data(), seq.size()));
+        }
+        const Golden got = hash_lines(lines);
+        report(got.sequences == expected.sequences && got.hash == expected.hash && gen.result().complete && !malformed,
+               "generator, n = " + std::to_string(n) + ": " + std::to_string(got.sequences) + " sequences, expected " +
+                   std::to_string(expected.sequences) + (got.hash == expected.hash ? ", hash matches" : ", hash differs"));
+    }
+
+    // A limit stops the search after exactly that many sequences
+    {
+        NS1D0SearchOptions options;
+        options.threads = 4;
+        options.limit = 10;
+        std::atomic<std::size_t> calls{0};
+        const NS1D0SearchResult r = ns1d0_search(19, options, [&](SequenceView) {
+            calls.fetch_add(1);
+            return true;
+        });
+        report(calls.load() == 10 && r.sequences == 10 && !r.complete,
+               "limit 10, n = 19: " + std::to_string(calls.load()) + " callbacks");
+    }
+
+    // Returning false stops the search; the other workers may each still deliver what they had in hand
+    {
+        NS1D0SearchOptions options;
+        options.threads = 4;
+        std::atomic<std::size_t> calls{0};
+        const NS1D0SearchResult r = ns1d0_search(21, options, [&](SequenceView) {
+            return calls.fetch_add(1) + 1 < 5;
+        });
+        // NS1D0(21) has 71292 sequences
+        report(calls.load() >= 5 && calls.load() < 71292 && !r.complete,
+               "callback returning false at 5, n = 21: " + std::to_string(calls.load()) + " callbacks");
+    }
+
+    // The cancel flag stops the search from outside the callback
+    {
+        std::atomic<bool> cancel{false};
+        std::atomic<std::size_t> calls{0};
+        NS1D0SearchOptions options;
+        options.threads = 4;
+        options.cancel = &cancel;
+        const auto start = std::chrono::steady_clock::now();
+        const NS1D0SearchResult r = ns1d0_search(23, options, [&](SequenceView) {
+            if (calls.fetch_add(1) + 1 == 100) {
+                cancel.store(true);
+            }
+            return true;
+        });
+        // NS1D0(23) has 542354 sequences
+        report(calls.load() >= 100 && calls.load() < 542354 && !r.complete,
+               "cancel flag set after 100, n = 23: " + std::to_string(calls.load()) + " callbacks in " +
+                   std::to_string(seconds_since(start)) + " s");
+    }
+
+    // Destroying a generator that is far from drained cancels its search
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t taken = 0;
+        {
+            NS1D0Generator gen(25, {}, 8);
+            std::vector<int> seq;
+            while (taken < 20 && gen.next(seq)) {
+                ++taken;
+            }
+        }
+        const double seconds = seconds_since(start);
+        report(taken == 20 && seconds < 5.0,
+               "generator destroyed after 20 of n = 25: returned in " + std::to_string(seconds) + " s");
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file bench/channel_bench.cpp
+ *
+ * @brief Throughput benchmark of Channel against BatchChannel.
+ *
+ * @section Overview
+ *
+ * Several producer threads push small std::vector<int> items (the same shape as
+ * an NS1D0 result) to a single consumer. Channel is fed one item at a time, the
+ * way the search used to publish results; BatchChannel is fed batches of the
+ * size the search uses now. Each configuration reports items per second.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../include/channel.h"
+#include "../include/batch_channel.h"
+
+static constexpr std::size_t kTotalItems = 2000000;
+static constexpr std::size_t kItemLength = 10;
+static constexpr std::size_t kBatchSize = 256;
+
+/**
+ * @brief Time producers pushing items one by one through a Channel.
+ *
+ * @param producers The number of producer threads.
+ *
+ * @return double Items per second.
+ */
+static double bench_channel(int producers) {
+    Channel<std::vector<int>> channel;
+    const std::size_t perProducer = kTotalItems / producers;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::size_t received = 0;
+    std::thread consumer([&] {
+        std::vector<int> item;
+        while (channel.pop(item)) {
+            ++received;
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            std::vector<int> item(kItemLength, p);
+            for (std::size_t i = 0; i < perProducer; ++i) {
+                channel.push(item);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    channel.close();
+    consumer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return received / seconds;
+}
+
+/**
+ * @brief Time producers publishing batches through a BatchChannel.
+ *
+ * @param producers The number of producer threads.
+ *
+ * @return double Items per second.
+ */
+static double bench_batch_channel(int producers) {
+    BatchChannel<std::vector<int>> channel;
+    const std::size_t perProducer = kTotalItems / producers;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::size_t received = 0;
+    std::thread consumer([&] {
+        std::vector<std::vector<std::vector<int>>> batches;
+        while (channel.pop_batches(batches)) {
+            for (const auto& batch : batches) {
+                received += batch.size();
+            }
+            batches.clear();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            std::vector<int> item(kItemLength, p);
+            std::vector<std::vector<int>> batch;
+            batch.reserve(kBatchSize);
+            for (std::size_t i = 0; i < perProducer; ++i) {
+                batch.push_back(item);
+                if (batch.size() == kBatchSize) {
+                    channel.push_batch(std::move(batch));
+                    batch.clear();
+                    batch.reserve(kBatchSize);
+                }
+            }
+            channel.push_batch(std::move(batch));
+        });
+    }
+    for (auto& t : threads) t.join();
+    channel.close();
+    consumer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return received / seconds;
+}
+
+int main() {
+    std::cout << "producers,channel_items_per_sec,batch_channel_items_per_sec,speedup" << std::endl;
+    for (int producers : {1, 8, 64}) {
+        const double plain = bench_channel(producers);
+        const double batched = bench_batch_channel(producers);
+        std::cout << producers << ","
+                  << static_cast<long long>(plain) << ","
+                  << static_cast<long long>(batched) << ","
+                  << batched / plain << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file bench/engine_bench.cpp
+ *
+ * @brief Cross-check of the two search engines, with their node counts and rates.
+ *
+ * @section Overview
+ *
+ * For every n the whole search runs three ways:
+ *
+ *   - dfs:       search_worker() with the default options (symmetry breaking, lookahead,
+ *                the specialized kernel where there is one),
+ *   - dfs-full:  search_worker() without symmetry breaking, so it visits every sequence,
+ *   - pairs:     pair_search_worker(), the difference-pair engine.
+ *
+ * Each count-only run is timed --repeat times on --threads workers, and the best
+ * is reported with its nodes and nodes/sec. Then dfs and pairs run once more,
+ * handing every sequence to a callback. The two sorted lists must be identical;
+ * the exit status is 1 if they differ for any n. The engines count nodes
+ * differently (see pair_search.h), so compare the node counts as trees, not as
+ * work per sequence.
+ *
+ * Usage: engine_bench [--threads t] [--repeat k] [n ...]      (defaults: 1 thread, 5 repeats, n = 7 9 ... 17)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ns1d0.h"
+#include "../include/ns1d0_api.h"
+#include "../include/pair_search.h"
+
+/**
+ * @brief The signature search_worker() and pair_search_worker() share.
+ */
+using WorkerFunction = void (*)(int, WorkStealingPool&, const NS1D0Config&, const SearchOptions&,
+                                ResultChannel&, SearchCounts&, std::atomic<std::size_t>&, LiveProgress&);
+
+/**
+ * @struct EngineRun
+ *
+ * @brief What one complete search did.
+ */
+struct EngineRun {
+    std::size_t nodes = 0;
+    std::size_t sequences = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Run a whole search on a fresh pool, the way bin/sequence does.
+ *
+ * @param worker The engine's worker function.
+ * @param tasks The engine's initial tasks.
+ * @param cfg Configuration of the n to search.
+ * @param opts Search options; count-only, or with onResult set.
+ * @param threads Number of workers.
+ *
+ * @return EngineRun The totals and the wall time.
+ */
+static EngineRun run_engine(WorkerFunction worker, const std::vector<SearchTask>& tasks,
+                            const NS1D0Config& cfg, const SearchOptions& opts, int threads) {
+    const auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        pool.push(static_cast<int>(i % threads), tasks[i]);
+    }
+
+    ResultChannel unused;
+    std::atomic<std::size_t> nodes{0};
+    std::vector<SearchCounts> counts(threads);
+    std::vector<LiveProgress> live(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(worker, i, std::ref(pool), std::cref(cfg), std::cref(opts), std::ref(unused),
+                             std::ref(counts[i]), std::ref(nodes), std::ref(live[i]));
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    EngineRun run;
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.nodes = nodes.load();
+    for (const SearchCounts& c : counts) {
+        run.sequences += c.sequences;
+    }
+    return run;
+}
+
+/**
+ * @brief The best of repeat count-only runs.
+ */
+static EngineRun best_run(WorkerFunction worker, const std::vector<SearchTask>& tasks,
+                          const NS1D0Config& cfg, SearchOptions opts, int threads, int repeat) {
+    opts.countOnly = true;
+    EngineRun best;
+    for (int r = 0; r < repeat; ++r) {
+        const EngineRun run = run_engine(worker, tasks, cfg, opts, threads);
+        if (r == 0 || run.seconds < best.seconds) {
+            best = run;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Every sequence an engine finds, sorted.
+ */
+static std::vector<std::vector<int>> collect(WorkerFunction worker, const std::vector<SearchTask>& tasks,
+                                             const NS1D0Config& cfg, SearchOptions opts, int threads) {
+    std::mutex mtx;
+    std::vector<std::vector<int>> found;
+    opts.onResult = [&](const int* seq, std::size_t length) {
+        std::lock_guard<std::mutex> lock(mtx);
+        found.emplace_back(seq, seq + length);
+        return true;
+    };
+    run_engine(worker, tasks, cfg, opts, threads);
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 1;
+    int repeat = 5;
+    std::vector<int> ns;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else {
+            const int n = std::atoi(argv[i]);
+            if (n < 3 || n % 2 != 1 || n > kMaxPairSearchN) {
+                std::cerr << "Usage: " << argv[0] << " [--threads t] [--repeat k] [n ...]  (odd 3 <= n <= "
+                          << kMaxPairSearchN << ")" << std::endl;
+                return 1;
+            }
+            ns.push_back(n);
+        }
+    }
+    if (threads < 1 || repeat < 1) {
+        std::cerr << "Error: threads and repeat must be positive." << std::endl;
+        return 1;
+    }
+    if (ns.empty()) {
+        ns = {7, 9, 11, 13, 15, 17};
+    }
+
+    std::cout << "Both engines, count-only, " << threads << " thread(s), best of " << repeat << "\n\n";
+    std::cout << std::setw(4) << "n" << std::setw(10) << "engine" << std::setw(12) << "sequences"
+              << std::setw(14) << "nodes" << std::setw(12) << "ms" << std::setw(14) << "Mnodes/s"
+              << std::setw(12) << "identical" << std::endl;
+
+    bool allIdentical = true;
+    for (int n : ns) {
+        const NS1D0Config cfg = ns1d0_config(n);
+        SearchOptions full;
+        full.symmetry = false;
+
+        const std::vector<SearchTask> dfsTasks = initial_search_tasks(cfg);
+        const std::vector<SearchTask> pairTasks = initial_pair_tasks(cfg);
+        const bool identical = collect(search_worker, dfsTasks, cfg, SearchOptions{}, threads) ==
+                               collect(pair_search_worker, pairTasks, cfg, SearchOptions{}, threads);
+        allIdentical = allIdentical && identical;
+
+        const struct {
+            const char* name;
+            EngineRun run;
+        } rows[] = {
+            {"dfs", best_run(search_worker, dfsTasks, cfg, SearchOptions{}, threads, repeat)},
+            {"dfs-full", best_run(search_worker, dfsTasks, cfg, full, threads, repeat)},
+            {"pairs", best_run(pair_search_worker, pairTasks, cfg, SearchOptions{}, threads, repeat)},
+        };
+        for (const auto& row : rows) {
+            std::cout << std::setw(4) << n << std::setw(10) << row.name << std::setw(12) << row.run.sequences
+                      << std::setw(14) << row.run.nodes << std::fixed << std::setprecision(3)
+                      << std::setw(12) << row.run.seconds * 1000.0 << std::setprecision(2)
+                      << std::setw(14) << row.run.nodes / row.run.seconds / 1e6
+                      << std::setw(12) << (identical ? "yes" : "NO") << std::endl;
+        }
+    }
+    return allIdentical ? 0 : 1;
+}
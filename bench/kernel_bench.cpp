@@ -0,0 +1,307 @@
+/**
+ * @file bench/kernel_bench.cpp
+ *
+ * @brief Microbenchmarks of the search kernels and the result channels.
+ *
+ * @section Overview
+ *
+ * Each kernel runs on its own, single-threaded, for several n:
+ *
+ *   - is_valid_prefix and each rule function on every prefix of a sample of valid sequences,
+ *   - the depth-first search (through search_worker) on the fixed subtree below {0, 2},
+ *     with the generic kernel and, where there is one, the kernel specialized for n,
+ *   - Channel and BatchChannel push/pop round trips of result-sized items,
+ *   - the result path of the workers: encoding into recycled slabs and draining them.
+ *
+ * For every kernel the benchmark reports ns/op, nodes/sec (search only) and heap
+ * allocations per op (see alloc_counter.h). The table goes
+ * to stdout; with --csv the same numbers are written as CSV so runs of different
+ * versions can be diffed.
+ *
+ * Usage: kernel_bench [--csv file] [n ...]      (default n: 13 17 21)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/ns1d0.h"
+#include "../include/search_state.h"
+#include "../include/fixed_search_state.h"
+#include "../include/channel.h"
+#include "../include/batch_channel.h"
+#include "../include/alloc_counter.h"
+
+static constexpr double kMinSeconds = 0.2;         // run each kernel at least this long
+static constexpr std::size_t kSampleSequences = 64; // valid sequences the rule inputs come from
+static constexpr std::size_t kBatchSize = 256;      // batch size of the BatchChannel kernel
+
+/**
+ * @struct BenchResult
+ *
+ * @brief One row of the report.
+ */
+struct BenchResult {
+    std::string kernel;
+    int n;
+    std::size_t ops;
+    double seconds;
+    std::size_t nodes;        // search nodes expanded; 0 for the other kernels
+    std::size_t allocations;
+};
+
+// Keeps the compiler from dropping the benchmarked calls
+static volatile std::size_t g_sink = 0;
+
+/**
+ * @brief Run body repeatedly until kMinSeconds have passed.
+ *
+ * @param kernel Name of the kernel.
+ * @param n The n the kernel runs for.
+ * @param body Runs a fixed amount of work and returns the number of ops it did.
+ *
+ * @return BenchResult The totals over all repetitions.
+ */
+static BenchResult time_kernel(const std::string& kernel, int n, const std::function<std::size_t()>& body) {
+    using Clock = std::chrono::steady_clock;
+    BenchResult r{kernel, n, 0, 0.0, 0, 0};
+
+    const std::size_t allocsBefore = heap_allocations();
+    const auto start = Clock::now();
+    do {
+        r.ops += body();
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (r.seconds < kMinSeconds);
+    r.allocations = heap_allocations() - allocsBefore;
+    return r;
+}
+
+/**
+ * @brief Collect up to kSampleSequences valid sequences with a plain depth-first search.
+ */
+static void collect_sequences(SearchState& state, std::vector<std::vector<int>>& out) {
+    if (state.complete()) {
+        out.push_back(state.sequence());
+        return;
+    }
+    for (int v = 0; v < state.config().n && out.size() < kSampleSequences; ++v) {
+        if (state.can_push(v)) {
+            state.push(v);
+            collect_sequences(state, out);
+            state.pop();
+        }
+    }
+}
+
+/**
+ * @brief Every prefix of a sample of valid sequences: the inputs of the rule kernels.
+ */
+static std::vector<std::vector<int>> rule_inputs(const NS1D0Config& cfg) {
+    SearchState state(cfg);
+    std::vector<std::vector<int>> sequences;
+    collect_sequences(state, sequences);
+
+    std::vector<std::vector<int>> prefixes;
+    for (const auto& seq : sequences) {
+        for (std::size_t len = 1; len <= seq.size(); ++len) {
+            prefixes.emplace_back(seq.begin(), seq.begin() + len);
+        }
+    }
+    return prefixes;
+}
+
+/**
+ * @brief Benchmark one rule-like function over all inputs.
+ */
+static BenchResult bench_rule(const std::string& kernel,
+                              const NS1D0Config& cfg,
+                              const std::vector<std::vector<int>>& inputs,
+                              bool (*rule)(const std::vector<int>&, const NS1D0Config&)) {
+    return time_kernel(kernel, cfg.n, [&] {
+        std::size_t passed = 0;
+        for (const auto& seq : inputs) {
+            passed += rule(seq, cfg);
+        }
+        g_sink = g_sink + passed;
+        return inputs.size();
+    });
+}
+
+/**
+ * @brief Benchmark the depth-first search on the subtree below {0, 2}, counting only.
+ *
+ * @details specialized picks the kernel compiled for cfg.n, if there is one, over the generic one.
+ */
+static BenchResult bench_dfs(const NS1D0Config& cfg, bool specialized) {
+    SearchOptions opts;
+    opts.symmetry = false;
+    opts.countOnly = true;
+    opts.specialized = specialized;
+
+    std::size_t nodes = 0;
+    BenchResult r = time_kernel(specialized ? "dfs_search_specialized" : "dfs_search_generic", cfg.n, [&] {
+        WorkStealingPool pool(1);
+        pool.push(0, SearchTask{{0, 2}, 0, cfg.n});
+        ResultChannel unused;
+        SearchCounts counts;
+        std::atomic<std::size_t> expanded{0};
+        LiveProgress live;
+        search_worker(0, pool, cfg, opts, unused, counts, expanded, live);
+        nodes += counts.nodes;
+        g_sink = g_sink + counts.sequences;
+        return static_cast<std::size_t>(counts.nodes);
+    });
+    r.nodes = nodes;
+    return r;
+}
+
+/**
+ * @brief Benchmark Channel push/pop round trips of result-sized items.
+ */
+static BenchResult bench_channel(const NS1D0Config& cfg) {
+    Channel<std::vector<int>> channel;
+    const std::vector<int> item(cfg.targetLength, 1);
+    std::vector<int> out;
+    return time_kernel("channel_push_pop", cfg.n, [&] {
+        for (int i = 0; i < 1000; ++i) {
+            channel.push(item);
+            channel.pop(out);
+        }
+        g_sink = g_sink + out.size();
+        return std::size_t{1000};
+    });
+}
+
+/**
+ * @brief Benchmark BatchChannel round trips of full batches; one op is one item.
+ */
+static BenchResult bench_batch_channel(const NS1D0Config& cfg) {
+    BatchChannel<std::vector<int>> channel;
+    const std::vector<int> item(cfg.targetLength, 1);
+    std::vector<std::vector<std::vector<int>>> batches;
+    return time_kernel("batch_channel_push_pop", cfg.n, [&] {
+        std::vector<std::vector<int>> batch(kBatchSize, item);
+        channel.push_batch(std::move(batch));
+        channel.pop_batches(batches);
+        g_sink = g_sink + batches.size();
+        batches.clear();
+        return kBatchSize;
+    });
+}
+
+/**
+ * @brief Benchmark the result path: encode into recycled slabs, publish, drain and hand back; one op is one sequence.
+ *
+ * @details One round is run before timing so the pool holds its slabs; after that
+ * the path should not allocate at all.
+ */
+static BenchResult bench_result_slabs(const NS1D0Config& cfg) {
+    ResultChannel channel;
+    ResultBatcher batcher(channel, SeqFormat::Text, cfg.n, cfg.targetLength);
+    std::vector<int> seq(cfg.targetLength);
+    for (int i = 0; i < cfg.targetLength; ++i) {
+        seq[i] = i;
+    }
+    std::vector<ResultSlab*> slabs;
+    auto round = [&] {
+        for (std::size_t i = 0; i < 4 * kResultBatchSize; ++i) {
+            batcher.add(seq.data());
+        }
+        batcher.flush();
+        channel.pop_all(slabs);
+        for (ResultSlab* slab : slabs) {
+            g_sink = g_sink + slab->bytes.size();
+            slab->owner->release(slab);
+        }
+        slabs.clear();
+        return 4 * kResultBatchSize;
+    };
+    round();
+    return time_kernel("result_slab_round_trip", cfg.n, round);
+}
+
+int main(int argc, char* argv[]) {
+    std::string csvPath;
+    std::vector<int> ns;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else {
+            const int n = std::atoi(argv[i]);
+            if (n < 5 || n % 2 != 1) {
+                std::cerr << "Usage: " << argv[0] << " [--csv file] [n ...]  (odd n >= 5)" << std::endl;
+                return 1;
+            }
+            ns.push_back(n);
+        }
+    }
+    if (ns.empty()) {
+        ns = {13, 17, 21};
+    }
+
+    std::vector<BenchResult> results;
+    for (int n : ns) {
+        const NS1D0Config cfg{n, (n - 1) / 2 + 1, (n + 1) / 2};
+        const auto inputs = rule_inputs(cfg);
+
+        results.push_back(bench_rule("is_valid_prefix", cfg, inputs, is_valid_prefix));
+        results.push_back(bench_rule("rule1_length", cfg, inputs, rule1_length));
+        results.push_back(bench_rule("rule_unique_and_in_range", cfg, inputs, rule_unique_and_in_range));
+        results.push_back(bench_rule("rule2_starts_with_zero", cfg, inputs,
+                                     [](const std::vector<int>& seq, const NS1D0Config&) {
+                                         return rule2_starts_with_zero(seq);
+                                     }));
+        results.push_back(bench_rule("rule3_one_at_end", cfg, inputs, rule3_one_at_end));
+        results.push_back(bench_rule("rule4_no_forbidden", cfg, inputs, rule4_no_forbidden));
+        results.push_back(bench_rule("rule5_pair_exclusion", cfg, inputs, rule5_pair_exclusion));
+        results.push_back(bench_rule("rule6_differences_unique_pairs", cfg, inputs, rule6_differences_unique_pairs));
+        results.push_back(bench_dfs(cfg, false));
+        if (has_specialized_state(n)) {
+            results.push_back(bench_dfs(cfg, true));
+        }
+        results.push_back(bench_channel(cfg));
+        results.push_back(bench_batch_channel(cfg));
+        results.push_back(bench_result_slabs(cfg));
+    }
+
+    std::ofstream csv;
+    if (!csvPath.empty()) {
+        csv.open(csvPath);
+        if (!csv.is_open()) {
+            std::cerr << "Error: Could not open " << csvPath << std::endl;
+            return 1;
+        }
+        csv << std::fixed;
+        csv << "kernel,n,ops,ns_per_op,nodes_per_sec,allocs_per_op" << std::endl;
+    }
+
+    std::cout << std::left << std::setw(32) << "kernel" << std::right
+              << std::setw(4) << "n" << std::setw(14) << "ns/op"
+              << std::setw(16) << "nodes/sec" << std::setw(14) << "allocs/op" << std::endl;
+    for (const BenchResult& r : results) {
+        const double nsPerOp = 1e9 * r.seconds / r.ops;
+        const double nodesPerSec = r.nodes / r.seconds;
+        const double allocsPerOp = static_cast<double>(r.allocations) / r.ops;
+
+        std::cout << std::left << std::setw(32) << r.kernel << std::right
+                  << std::setw(4) << r.n
+                  << std::setw(14) << std::fixed << std::setprecision(2) << nsPerOp
+                  << std::setw(16) << std::setprecision(0) << nodesPerSec
+                  << std::setw(14) << std::setprecision(4) << allocsPerOp << std::endl;
+        if (csv.is_open()) {
+            csv << r.kernel << "," << r.n << "," << r.ops << ","
+                << std::setprecision(3) << nsPerOp << ","
+                << std::setprecision(0) << nodesPerSec << ","
+                << std::setprecision(4) << allocsPerOp << std::endl;
+        }
+    }
+    return 0;
+}
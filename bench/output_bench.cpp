@@ -0,0 +1,180 @@
+/**
+ * @file bench/output_bench.cpp
+ *
+ * @brief Throughput of the result writer: the old ostream path against the buffered, pre-encoded one.
+ *
+ * @section Overview
+ *
+ * The same synthetic sequences are written to one file with three writers, in
+ * every format:
+ *
+ *   - ostream:  what the output thread used to do; text through operator<< per
+ *               element, binary records through one ostream::write each,
+ *   - buffered: SeqFileWriter::write, i.e. std::to_chars into the writer's buffer,
+ *               all on the writing thread,
+ *   - encoded:  SeqEncoder into chunks of kResultBatchSize sequences, as the
+ *               workers now do, then SeqFileWriter::write_encoded. The encode
+ *               time is reported on its own line; the write time is what the
+ *               output thread is left with.
+ *
+ * Each row reports sequences/s and MB/s, including the final flush to the file.
+ *
+ * Usage: output_bench [--n n] [--count sequences] [--file path]
+ *        (defaults: n = 41, 2000000 sequences, output_bench.out, removed afterwards)
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/ns1d0.h"
+#include "../include/seqfile.h"
+
+/**
+ * @brief Random elements in [0, n), deterministic across runs.
+ */
+static std::vector<int> sample_elements(int n, int length, std::size_t count) {
+    std::vector<int> elements(static_cast<std::size_t>(length) * count);
+    std::uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (int& v : elements) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        v = static_cast<int>((state >> 33) % static_cast<std::uint64_t>(n));
+    }
+    return elements;
+}
+
+/**
+ * @brief Seconds one call of body takes.
+ */
+static double time_seconds(const std::function<void()>& body) {
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Print one row of the report.
+ */
+static void report(const char* mode, SeqFormat format, std::size_t sequences, std::size_t bytes, double seconds) {
+    std::cout << std::left << std::setw(10) << mode
+              << std::setw(8) << seq_format_name(format)
+              << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds
+              << std::setw(14) << std::setprecision(0) << sequences / seconds
+              << std::setw(10) << std::setprecision(1) << bytes / seconds / 1e6
+              << std::endl;
+}
+
+/**
+ * @brief The output thread's old text loop: one operator<< per element and separator.
+ */
+static void write_ostream_text(std::ostream& out, const int* seq, int length) {
+    for (int i = 0; i < length; ++i) {
+        out << seq[i];
+        if (i + 1 < length) {
+            out << ", ";
+        }
+    }
+    out << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    int n = 41;
+    std::size_t count = 2000000;
+    std::string path = "output_bench.out";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--n" && i + 1 < argc) {
+            n = std::atoi(argv[++i]);
+        } else if (arg == "--count" && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--file" && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--n n] [--count sequences] [--file path]" << std::endl;
+            return 1;
+        }
+    }
+    if (n < 3 || n > 256 || count == 0) {
+        std::cerr << "Error: n must be in [3, 256] and count positive." << std::endl;
+        return 1;
+    }
+
+    const int length = (n - 1) / 2 + 1;
+    const std::vector<int> elements = sample_elements(n, length, count);
+    auto seq = [&](std::size_t i) { return elements.data() + i * length; };
+
+    std::cout << "Writing " << count << " sequences of length " << length << " (n = " << n << ") to " << path << "\n\n";
+    std::cout << std::left << std::setw(10) << "mode" << std::setw(8) << "format"
+              << std::right << std::setw(10) << "seconds" << std::setw(14) << "seq/s" << std::setw(10) << "MB/s"
+              << std::endl;
+
+    for (SeqFormat format : {SeqFormat::Text, SeqFormat::Bytes, SeqFormat::Packed}) {
+        const SeqEncoder encoder(format, n, length);
+        std::size_t bytes = 0;
+
+        // ostream: the old path
+        double seconds = time_seconds([&] {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            std::vector<char> record;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (format == SeqFormat::Text) {
+                    write_ostream_text(out, seq(i), length);
+                } else {
+                    record.clear();
+                    encoder.encode(seq(i), record);
+                    out.write(record.data(), static_cast<std::streamsize>(record.size()));
+                }
+            }
+            out.flush();
+            bytes = static_cast<std::size_t>(out.tellp());
+        });
+        report("ostream", format, count, bytes, seconds);
+
+        // buffered: to_chars into the writer's buffer
+        seconds = time_seconds([&] {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            SeqFileWriter writer(out, format, n, length, false);
+            for (std::size_t i = 0; i < count; ++i) {
+                writer.write(seq(i));
+            }
+            writer.flush();
+        });
+        report("buffered", format, count, bytes, seconds);
+
+        // encoded: chunks built as in the workers, then only copied by the writer
+        std::vector<ResultSlab> chunks;
+        seconds = time_seconds([&] {
+            for (std::size_t i = 0; i < count; ++i) {
+                if (chunks.empty() || chunks.back().count == kResultBatchSize) {
+                    chunks.emplace_back();
+                    chunks.back().bytes.reserve(kResultBatchSize * encoder.max_bytes());
+                }
+                encoder.encode(seq(i), chunks.back().bytes);
+                ++chunks.back().count;
+            }
+        });
+        report("encode", format, count, bytes, seconds);
+        seconds = time_seconds([&] {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            SeqFileWriter writer(out, format, n, length, false);
+            for (const ResultSlab& chunk : chunks) {
+                writer.write_encoded(chunk.bytes.data(), chunk.bytes.size());
+            }
+            writer.flush();
+        });
+        report("encoded", format, count, bytes, seconds);
+        std::cout << std::endl;
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
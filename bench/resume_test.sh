@@ -0,0 +1,141 @@
+#!/bin/sh
+#
+# Crash test of --checkpoint and --resume; run by `make test-resume`.
+#
+# For each of text output, bytes output and --count-only, search n once without
+# interruption, then search it again with checkpoints every INTERVAL seconds,
+# kill -9 the process KILLS times, each after a random 5 to 95% of the clean
+# run's time, resuming after every kill,
+# and let the last resume finish. The sorted output (or the count) must be the
+# same as the clean run's. Finally time a count-only search of BIG_N with and
+# without checkpoints, to show what they cost.
+#
+# Usage: resume_test.sh <sequence> <seqconvert> [n] [kills] [interval] [big_n]
+#        (defaults: n = 21, 3 kills, 0.05 s, big_n = 23)
+
+SEQUENCE=$1
+CONVERT=$2
+N=${3:-21}
+KILLS=${4:-3}
+INTERVAL=${5:-0.05}
+BIG_N=${6:-23}
+
+if [ -z "$SEQUENCE" ] || [ -z "$CONVERT" ]; then
+    echo "Usage: $0 <sequence> <seqconvert> [n] [kills] [interval] [big_n]" >&2
+    exit 1
+fi
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+FAILED=0
+
+now() {
+    date +%s.%N
+}
+
+# Seconds from $1 to $2, with millisecond precision
+elapsed() {
+    awk -v a="$1" -v b="$2" 'BEGIN { printf "%.3f", b - a }'
+}
+
+# A random delay between 5% and 95% of $1 seconds
+random_delay() {
+    r=$(od -An -N2 -tu2 /dev/urandom | tr -d ' ')
+    awk -v r="$r" -v t="$1" 'BEGIN { printf "%.3f", t * (0.05 + (r % 900) / 1000) }'
+}
+
+# The sequences of a result file as sorted text
+sorted_text() {
+    if [ "$2" = text ]; then
+        LC_ALL=C sort "$1"
+    else
+        "$CONVERT" to-text "$1" "$1.txt" > /dev/null && LC_ALL=C sort "$1.txt"
+    fi
+}
+
+# The sequence count a run printed
+found() {
+    sed -n 's/^Valid sequences found: //p' "$1"
+}
+
+for MODE in text bytes count; do
+    case $MODE in
+        text)  TARGET="$DIR/out.txt"; OPTS="" ;;
+        bytes) TARGET="$DIR/out.bin"; OPTS="--format bytes" ;;
+        count) TARGET="--count-only"; OPTS="" ;;
+    esac
+    CLEAN="$DIR/clean.$MODE"
+    CKPT="$DIR/ckpt.$MODE"
+    T0=$(now)
+    if [ $MODE = count ]; then
+        "$SEQUENCE" "$N" --count-only > "$CLEAN.log"
+    else
+        "$SEQUENCE" "$N" "$CLEAN" $OPTS > "$CLEAN.log"
+    fi
+    CLEAN_SECONDS=$(elapsed "$T0" "$(now)")
+
+    # Kill and resume; without a checkpoint yet, the run starts over
+    KILLED=""
+    STATUS=1
+    i=0
+    while [ $i -le "$KILLS" ]; do
+        if [ -f "$CKPT" ]; then
+            START="--resume $CKPT"
+        else
+            START="--checkpoint $CKPT"
+        fi
+        "$SEQUENCE" "$N" $TARGET $OPTS $START --checkpoint-interval "$INTERVAL" > "$DIR/run.log" 2>&1 &
+        PID=$!
+        if [ $i -lt "$KILLS" ]; then
+            DELAY=$(random_delay "$CLEAN_SECONDS")
+            sleep "$DELAY"
+            kill -9 $PID 2> /dev/null && KILLED="$KILLED ${DELAY}s"
+        fi
+        wait $PID 2> /dev/null
+        STATUS=$?
+        [ $STATUS -eq 0 ] && break
+        i=$((i + 1))
+    done
+
+    if [ $STATUS -ne 0 ]; then
+        echo "$MODE: FAILED, the last resume exited with status $STATUS"
+        cat "$DIR/run.log"
+        FAILED=1
+        continue
+    fi
+    if [ $MODE = count ]; then
+        [ "$(found "$DIR/run.log")" = "$(found "$CLEAN.log")" ]
+    else
+        sorted_text "$CLEAN" $MODE > "$DIR/clean.sorted"
+        sorted_text "$TARGET" $MODE > "$DIR/resumed.sorted"
+        cmp -s "$DIR/clean.sorted" "$DIR/resumed.sorted"
+    fi
+    if [ $? -eq 0 ]; then
+        if [ -n "$KILLED" ]; then
+            echo "$MODE: killed at$KILLED, resumed; $(found "$DIR/run.log") sequences, identical"
+        else
+            echo "$MODE: finished before the first kill; $(found "$DIR/run.log") sequences, identical"
+        fi
+    else
+        echo "$MODE: FAILED, the resumed run differs from the clean run (killed at$KILLED)"
+        FAILED=1
+    fi
+done
+
+# What checkpoints cost on a longer run, at a far shorter interval than the default;
+# best of two runs each, alternating, since one run of each is mostly noise
+PLAIN=""
+WITH=""
+for r in 1 2; do
+    T0=$(now)
+    "$SEQUENCE" "$BIG_N" --count-only > /dev/null
+    T1=$(now)
+    "$SEQUENCE" "$BIG_N" --count-only --checkpoint "$DIR/big.ckpt" --checkpoint-interval 1 > "$DIR/big.log"
+    T2=$(now)
+    PLAIN=$(awk -v best="$PLAIN" -v t="$(elapsed "$T0" "$T1")" 'BEGIN { print (best == "" || t < best) ? t : best }')
+    WITH=$(awk -v best="$WITH" -v t="$(elapsed "$T1" "$T2")" 'BEGIN { print (best == "" || t < best) ? t : best }')
+done
+awk -v n="$BIG_N" -v a="$PLAIN" -v b="$WITH" -v c="$(sed -n 's/^Checkpoints written: \([0-9]*\).*/\1/p' "$DIR/big.log")" \
+    'BEGIN { printf "n = %d count-only: %.3f s without checkpoints, %.3f s with %d (1 s interval), overhead %+.2f%%\n", n, a, b, c, (b - a) / a * 100 }'
+
+exit $FAILED
@@ -0,0 +1,394 @@
+/**
+ * @file bench/scale_bench.cpp
+ *
+ * @brief End-to-end scaling of bin/sequence over thread counts, gated on golden output.
+ *
+ * @section Overview
+ *
+ * Every odd n in [lo, hi] is searched by bin/sequence, writing text output, with
+ * --threads 1, 2, 4, ... up to the core count (and the core count itself). For
+ * every run the harness records:
+ *
+ *   - wall time of the process and the search time it reports,
+ *   - nodes expanded and nodes/sec,
+ *   - speedup over one thread and parallel efficiency (speedup / threads), both
+ *     from the search time, so process start-up is left out.
+ *
+ * Each (n, threads) pair runs --repeat times and the fastest run is kept. The
+ * table goes to stdout, and --csv / --json write the same rows to files.
+ *
+ * Every run is also checked. Its sorted output must match the golden count and
+ * hash in bench/golden.txt, and its node count must equal the one-thread run,
+ * since splitting never changes the tree. --min-efficiency fails runs that
+ * scale worse than a given efficiency. --baseline takes the CSV of an earlier
+ * run and fails any (n, threads) whose nodes/sec dropped below --tolerance
+ * times the old value. The exit status is 1 if any check failed.
+ *
+ * Usage: scale_bench [--range lo:hi] [--max-threads t] [--repeat k] [--binary path]
+ *                    [--golden file] [--csv file] [--json file]
+ *                    [--baseline file] [--tolerance f] [--min-efficiency e]
+ *        (defaults: 7:15, one thread per core (also for t = 0), 3 repeats, bin/sequence, bench/golden.txt, tolerance 0.7)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Where the runs write their output; removed at the end.
+ */
+static const char* const kScratchFile = "scale_bench_output.txt";
+
+/**
+ * @struct Golden
+ *
+ * @brief The expected output for one n.
+ *
+ * @var sequences Number of sequences.
+ * @var hash FNV-1a 64 of the output's lines, sorted bytewise, each followed by a newline.
+ */
+struct Golden {
+    std::size_t sequences = 0;
+    std::uint64_t hash = 0;
+};
+
+/**
+ * @struct ScaleRow
+ *
+ * @brief One (n, threads) measurement.
+ */
+struct ScaleRow {
+    int n = 0;
+    int threads = 0;
+    double wallSeconds = 0.0;
+    double searchSeconds = 0.0;
+    std::size_t nodes = 0;
+    std::size_t sequences = 0;
+    double speedup = 0.0;
+    double efficiency = 0.0;
+    bool golden = false;
+
+    double nodes_per_sec() const { return searchSeconds > 0.0 ? nodes / searchSeconds : 0.0; }
+};
+
+/**
+ * @brief Load the golden file: one "n sequences hash" line per n; # starts a comment.
+ */
+static bool load_golden(const std::string& path, std::map<int, Golden>& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        int n;
+        Golden g;
+        std::string hash;
+        if (fields >> n >> g.sequences >> hash) {
+            g.hash = std::strtoull(hash.c_str(), nullptr, 16);
+            out[n] = g;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Count and hash a text result file the way bench/golden.txt does.
+ */
+static bool hash_output(const std::string& path, Golden& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end());
+
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](char c) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    };
+    for (const std::string& l : lines) {
+        for (char c : l) add(c);
+        add('\n');
+    }
+    out.sequences = lines.size();
+    out.hash = hash;
+    return true;
+}
+
+/**
+ * @brief Run bin/sequence once and read the totals from its report.
+ *
+ * @return bool False if the process failed or its report could not be read.
+ */
+static bool run_search(const std::string& binary, int n, int threads, ScaleRow& row) {
+    const std::string command = binary + " " + std::to_string(n) + " " + kScratchFile +
+                                " --threads " + std::to_string(threads);
+    const auto start = std::chrono::steady_clock::now();
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+    bool haveNodes = false;
+    bool haveTime = false;
+    char buffer[512];
+    while (std::fgets(buffer, sizeof(buffer), pipe)) {
+        const std::string line = buffer;
+        unsigned long long value;
+        double seconds;
+        if (std::sscanf(line.c_str(), "Nodes expanded: %llu", &value) == 1) {
+            row.nodes = value;
+            haveNodes = true;
+        } else if (std::sscanf(line.c_str(), "Valid sequences found: %llu", &value) == 1) {
+            row.sequences = value;
+        } else if (std::sscanf(line.c_str(), "Search time: %lf", &seconds) == 1) {
+            row.searchSeconds = seconds;
+            haveTime = true;
+        }
+    }
+    const int status = pclose(pipe);
+    row.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return status == 0 && haveNodes && haveTime;
+}
+
+/**
+ * @brief Thread counts to try: powers of two up to max, then max itself.
+ */
+static std::vector<int> thread_counts(int max) {
+    std::vector<int> counts;
+    for (int t = 1; t <= max; t *= 2) {
+        counts.push_back(t);
+    }
+    if (counts.back() != max) {
+        counts.push_back(max);
+    }
+    return counts;
+}
+
+/**
+ * @brief Load the nodes/sec of an earlier run's CSV, by (n, threads).
+ */
+static bool load_baseline(const std::string& path, std::map<std::pair<int, int>, double>& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        int n;
+        int threads;
+        double wall;
+        double search;
+        unsigned long long nodes;
+        double rate;
+        if (std::sscanf(line.c_str(), "%d,%d,%lf,%lf,%llu,%lf", &n, &threads, &wall, &search, &nodes, &rate) == 6) {
+            out[{n, threads}] = rate;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write the rows as CSV; --baseline reads this format back.
+ */
+static void write_csv(const std::string& path, const std::vector<ScaleRow>& rows) {
+    std::ofstream out(path);
+    out << "n,threads,wall_seconds,search_seconds,nodes,nodes_per_sec,speedup,efficiency,sequences,golden\n";
+    out << std::setprecision(6);
+    for (const ScaleRow& r : rows) {
+        out << r.n << "," << r.threads << "," << r.wallSeconds << "," << r.searchSeconds << ","
+            << r.nodes << "," << r.nodes_per_sec() << "," << r.speedup << "," << r.efficiency << ","
+            << r.sequences << "," << (r.golden ? "ok" : "FAIL") << "\n";
+    }
+}
+
+/**
+ * @brief Write the rows and the verdict as one JSON object.
+ */
+static void write_json(const std::string& path, const std::vector<ScaleRow>& rows, bool passed) {
+    std::ofstream out(path);
+    out << std::setprecision(6);
+    out << "{\n  \"passed\": " << (passed ? "true" : "false") << ",\n  \"runs\": [\n";
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const ScaleRow& r = rows[i];
+        out << "    {\"n\": " << r.n << ", \"threads\": " << r.threads
+            << ", \"wall_seconds\": " << r.wallSeconds << ", \"search_seconds\": " << r.searchSeconds
+            << ", \"nodes\": " << r.nodes << ", \"nodes_per_sec\": " << r.nodes_per_sec()
+            << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency
+            << ", \"sequences\": " << r.sequences << ", \"golden\": " << (r.golden ? "true" : "false")
+            << "}" << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    int lo = 7;
+    int hi = 15;
+    int maxThreads = 0;
+    int repeat = 3;
+    std::string binary = "bin/sequence";
+    std::string goldenPath = "bench/golden.txt";
+    std::string csvPath;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.7;
+    double minEfficiency = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        char sep = 0;
+        if (arg == "--range" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d%c%d", &lo, &sep, &hi) != 3 || sep != ':') {
+                lo = 0;
+            }
+        } else if (arg == "--max-threads" && i + 1 < argc) {
+            maxThreads = std::atoi(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (arg == "--binary" && i + 1 < argc) {
+            binary = argv[++i];
+        } else if (arg == "--golden" && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--min-efficiency" && i + 1 < argc) {
+            minEfficiency = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--range lo:hi] [--max-threads t] [--repeat k] [--binary path]"
+                      << " [--golden file] [--csv file] [--json file] [--baseline file] [--tolerance f]"
+                      << " [--min-efficiency e]" << std::endl;
+            return 1;
+        }
+    }
+    if (maxThreads < 1) {
+        maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    if (lo <= 1 || lo % 2 != 1 || hi < lo || repeat < 1) {
+        std::cerr << "Error: The range must be lo:hi with odd lo > 1 and hi >= lo, and repeat positive." << std::endl;
+        return 1;
+    }
+
+    std::map<int, Golden> golden;
+    if (!load_golden(goldenPath, golden)) {
+        std::cerr << "Error: Could not read " << goldenPath << "." << std::endl;
+        return 1;
+    }
+    std::map<std::pair<int, int>, double> baseline;
+    if (!baselinePath.empty() && !load_baseline(baselinePath, baseline)) {
+        std::cerr << "Error: Could not read " << baselinePath << "." << std::endl;
+        return 1;
+    }
+
+    const std::vector<int> threadCounts = thread_counts(maxThreads);
+    std::cout << "Scaling of " << binary << " over n = " << lo << ".." << hi << ", best of " << repeat << "\n\n";
+    std::cout << std::setw(4) << "n" << std::setw(9) << "threads" << std::setw(11) << "wall ms"
+              << std::setw(12) << "search ms" << std::setw(14) << "nodes" << std::setw(12) << "Mnodes/s"
+              << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::setw(9) << "golden" << std::endl;
+
+    std::vector<ScaleRow> rows;
+    std::vector<std::string> failures;
+    for (int n = lo; n <= hi; n += 2) {
+        const auto expected = golden.find(n);
+        if (expected == golden.end()) {
+            failures.push_back("n = " + std::to_string(n) + " has no golden entry in " + goldenPath);
+            continue;
+        }
+        // The one-thread run comes first; the others are measured against it
+        double baseSeconds = 0.0;
+        std::size_t baseNodes = 0;
+        for (int threads : threadCounts) {
+            const std::string where = "n = " + std::to_string(n) + " on " + std::to_string(threads) +
+                                      (threads == 1 ? " thread: " : " threads: ");
+            ScaleRow best;
+            bool ran = true;
+            bool matched = true;
+            for (int r = 0; r < repeat; ++r) {
+                ScaleRow row;
+                row.n = n;
+                row.threads = threads;
+                if (!run_search(binary, n, threads, row)) {
+                    ran = false;
+                    break;
+                }
+                Golden got;
+                matched = matched && hash_output(kScratchFile, got) && row.sequences == got.sequences &&
+                          got.sequences == expected->second.sequences && got.hash == expected->second.hash;
+                if (r == 0 || row.searchSeconds < best.searchSeconds) {
+                    best = row;
+                }
+            }
+            if (!ran) {
+                failures.push_back(where + "the run failed");
+                continue;
+            }
+            best.golden = matched;
+            if (!matched) {
+                failures.push_back(where + "the output does not match the golden count and hash");
+            }
+            if (threads == 1) {
+                baseSeconds = best.searchSeconds;
+                baseNodes = best.nodes;
+            }
+            best.speedup = best.searchSeconds > 0.0 ? baseSeconds / best.searchSeconds : 0.0;
+            best.efficiency = best.speedup / threads;
+            if (best.nodes != baseNodes) {
+                failures.push_back(where + std::to_string(best.nodes) + " nodes against " +
+                                   std::to_string(baseNodes) + " on one thread");
+            }
+            if (threads > 1 && best.efficiency < minEfficiency) {
+                failures.push_back(where + "parallel efficiency below the minimum");
+            }
+            const auto old = baseline.find({n, threads});
+            if (old != baseline.end() && best.nodes_per_sec() < tolerance * old->second) {
+                std::ostringstream msg;
+                msg << where << "nodes/sec fell below " << tolerance << " of the baseline";
+                failures.push_back(msg.str());
+            }
+            rows.push_back(best);
+
+            std::cout << std::setw(4) << best.n << std::setw(9) << best.threads << std::fixed << std::setprecision(2)
+                      << std::setw(11) << best.wallSeconds * 1000.0 << std::setw(12) << best.searchSeconds * 1000.0
+                      << std::setw(14) << best.nodes << std::setw(12) << best.nodes_per_sec() / 1e6
+                      << std::setw(10) << best.speedup << std::setw(12) << best.efficiency
+                      << std::setw(9) << (best.golden ? "ok" : "FAIL") << std::endl;
+        }
+    }
+    std::remove(kScratchFile);
+
+    const bool passed = failures.empty();
+    if (!csvPath.empty()) {
+        write_csv(csvPath, rows);
+    }
+    if (!jsonPath.empty()) {
+        write_json(jsonPath, rows, passed);
+    }
+    for (const std::string& f : failures) {
+        std::cerr << "FAIL: " << f << std::endl;
+    }
+    std::cout << (passed ? "\nAll runs match the golden output." : "\nScaling check FAILED.") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file bench/sweep_bench.cpp
+ *
+ * @brief Makespan of a sweep over several n: one bin/sequence process per n against one --range process.
+ *
+ * @section Overview
+ *
+ * The same count-only sweep over every odd n in [lo, hi] is run three ways:
+ *
+ *   - sequential: one bin/sequence process per n, one after another, as a shell
+ *                 loop would run them,
+ *   - concurrent: one process per n, all started at once, each with its own
+ *                 threads and competing for the cores,
+ *   - range:      a single bin/sequence --range lo:hi, with every n in one pool.
+ *
+ * Each mode runs --repeat times and the best makespan (wall time from the first
+ * start to the last exit) is reported, along with its ratio to the range mode.
+ * Counting only keeps file I/O out of the comparison.
+ *
+ * Usage: sweep_bench [--range lo:hi] [--repeat k] [--binary path] [-- extra bin/sequence options]
+ *        (defaults: 7:21, 3 repeats, bin/sequence)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief Seconds a shell command takes, or a negative number if it fails.
+ */
+static double time_command(const std::string& command) {
+    const auto start = std::chrono::steady_clock::now();
+    if (std::system(command.c_str()) != 0) {
+        return -1.0;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief The best of repeat runs of a command; negative if any of them fails.
+ */
+static double best_of(const std::string& command, int repeat) {
+    double best = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        const double seconds = time_command(command);
+        if (seconds < 0.0) {
+            std::cerr << "Error: Command failed: " << command << std::endl;
+            return -1.0;
+        }
+        best = r == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int lo = 7;
+    int hi = 21;
+    int repeat = 3;
+    std::string binary = "bin/sequence";
+    std::string extra;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        char sep = 0;
+        if (arg == "--range" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d%c%d", &lo, &sep, &hi) != 3 || sep != ':') {
+                lo = 0;
+            }
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (arg == "--binary" && i + 1 < argc) {
+            binary = argv[++i];
+        } else if (arg == "--") {
+            for (++i; i < argc; ++i) {
+                extra += std::string(" ") + argv[i];
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--range lo:hi] [--repeat k] [--binary path] [-- extra bin/sequence options]" << std::endl;
+            return 1;
+        }
+    }
+    if (lo <= 1 || lo % 2 != 1 || hi < lo || repeat < 1) {
+        std::cerr << "Error: The range must be lo:hi with odd lo > 1 and hi >= lo, and repeat positive." << std::endl;
+        return 1;
+    }
+
+    const std::string options = " --count-only" + extra + " > /dev/null";
+    std::string sequential;
+    std::string concurrent;
+    for (int n = lo; n <= hi; n += 2) {
+        const std::string run = binary + " " + std::to_string(n) + options;
+        sequential += (sequential.empty() ? "" : " && ") + run;
+        concurrent += "(" + run + ") & ";
+    }
+    concurrent += "wait";
+    const std::string range = binary + " --range " + std::to_string(lo) + ":" + std::to_string(hi) + options;
+
+    std::cout << "Sweep over n = " << lo << ".." << hi << ", count-only, best of " << repeat << "\n\n";
+    std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(12) << "seconds"
+              << std::setw(12) << "vs range" << std::endl;
+
+    const double rangeSeconds = best_of(range, repeat);
+    const double sequentialSeconds = best_of(sequential, repeat);
+    const double concurrentSeconds = best_of(concurrent, repeat);
+    if (rangeSeconds < 0.0 || sequentialSeconds < 0.0 || concurrentSeconds < 0.0) {
+        return 1;
+    }
+
+    auto row = [&](const char* mode, double seconds) {
+        std::cout << std::left << std::setw(12) << mode << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(3) << seconds
+                  << std::setw(11) << std::setprecision(2) << seconds / rangeSeconds << "x" << std::endl;
+    };
+    row("sequential", sequentialSeconds);
+    row("concurrent", concurrentSeconds);
+    row("range", rangeSeconds);
+    return 0;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file include/alloc_counter.h
+ *
+ * @brief A process-wide count of heap allocations, for checking that hot paths do not allocate.
+ *
+ * @details The count comes from replacing the global operator new in
+ * src/alloc_counter.cpp. That object file is linked into the tools and benchmarks
+ * that report it, never into libns1d0, so programs embedding the library keep
+ * their own allocator.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Heap allocations made through operator new so far, by every thread.
+ *
+ * @return std::size_t The count.
+ */
+std::size_t heap_allocations();
@@ -0,0 +1,274 @@
+/**
+ * @file include/batch_channel.h
+ *
+ * @brief A lock-free multi-producer, single-consumer channel that moves items in batches.
+ *
+ * @section Overview
+ *
+ * Channel<T> takes a mutex and signals its condition variable for every item, so
+ * many producers pushing small items all serialize on that one lock. Here each
+ * producer fills a local batch and publishes it with a single compare-and-swap
+ * onto an intrusive stack. The consumer takes the whole stack with one exchange
+ * and only sleeps (and is only woken) when the channel is actually empty.
+ *
+ * With a capacity (high-water mark), push_batch spins briefly and then blocks
+ * while the channel holds that many items, so a slow consumer applies
+ * backpressure instead of letting the queue grow without limit. Items count
+ * against the capacity until pop_batches hands them out, so at most about two
+ * capacities' worth of items are alive at once.
+ *
+ * The lock-free part is IntrusiveChannel, which links caller-owned nodes and
+ * never allocates. BatchChannel allocates one node per batch on top of it;
+ * producers that recycle their own nodes use IntrusiveChannel directly.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "channel.h"
+
+/**
+ * @class IntrusiveChannel
+ *
+ * @brief The lock-free core of BatchChannel, moving caller-owned nodes without allocating.
+ *
+ * @tparam Node A node type with a `Node* next` member for the channel to link through.
+ *
+ * @details The producer owns a node until push() and the consumer owns it after
+ * pop_all(); the channel never allocates or frees one. Each node counts as a
+ * given number of items against the capacity. Nodes from one producer are
+ * received in the order they were pushed. Only one thread may call pop_all().
+ * A capacity of 0 (the default) means unbounded.
+ */
+template <typename Node>
+class IntrusiveChannel {
+    public:
+        explicit IntrusiveChannel(std::size_t capacity = 0): capacity_(capacity) {}
+
+        // Disable copying
+        IntrusiveChannel(const IntrusiveChannel&) = delete;
+        IntrusiveChannel& operator =(const IntrusiveChannel&) = delete;
+
+        // Publish a node standing for count items with one atomic operation.
+        // Blocks while a bounded channel is at its high-water mark.
+        // Returns false, and leaves the node with the caller, if the channel is closed.
+        bool push(Node* node, std::size_t count) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            if (capacity_ > 0) {
+                wait_for_room(count);
+            }
+            counters_.record_size(queued_.fetch_add(count) + count);
+
+            node->next = head_.load(std::memory_order_relaxed);
+            // seq_cst pairs with the consumer's store to consumerWaiting_ so that
+            // either it sees this node or we see that it is waiting
+            while (!head_.compare_exchange_weak(node->next, node,
+                                                std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+            }
+
+            // Only pay for the mutex when the consumer is actually asleep
+            if (consumerWaiting_.load()) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                cv_not_empty.notify_one();
+            }
+            return true;
+        }
+
+        // Take every node published so far, oldest first, appending them to out.
+        // counted(node) must return the count the node was pushed with.
+        // Blocks while the channel is empty and open.
+        // Returns false when the channel is closed and empty.
+        template <typename Counted>
+        bool pop_all(std::vector<Node*>& out, Counted counted) {
+            Node* list = head_.exchange(nullptr, std::memory_order_acquire);
+
+            if (!list) {
+                std::unique_lock<std::mutex> lock(mtx_);
+                consumerWaiting_.store(true);
+                cv_not_empty.wait(lock, [&] {
+                    return closed_.load() || head_.load() != nullptr;
+                });
+                consumerWaiting_.store(false);
+                list = head_.exchange(nullptr, std::memory_order_acquire);
+            }
+
+            if (!list) {
+                // closed_ must be true here
+                return false;
+            }
+
+            // The stack is newest first; reverse it to restore push order
+            std::size_t taken = 0;
+            Node* ordered = nullptr;
+            while (list) {
+                Node* next = list->next;
+                taken += counted(*list);
+                list->next = ordered;
+                ordered = list;
+                list = next;
+            }
+            release(taken);
+
+            for (; ordered; ordered = ordered->next) {
+                out.push_back(ordered);
+            }
+            return true;
+        }
+
+        // Close the channel. After this:
+        // - a waiting pop_all wakes up and drains what is left
+        // - future pushes fail (return false)
+        void close() {
+            std::lock_guard<std::mutex> lock(mtx_);
+            closed_.store(true);
+            cv_not_empty.notify_all();
+            cv_not_full.notify_all();
+        }
+
+        // Nodes still in the channel, newest first; for freeing them after the last pop.
+        Node* take_remaining() { return head_.exchange(nullptr); }
+
+        // Backpressure counters so far.
+        ChannelStats stats() const { return counters_.snapshot(); }
+
+    private:
+        // Spin this many times before a full channel puts the producer to sleep.
+        static constexpr int kSpinLimit = 64;
+
+        bool has_room(std::size_t count) const {
+            const std::size_t queued = queued_.load();
+            // A batch larger than the capacity still goes through once the channel is empty
+            return queued == 0 || queued + count <= capacity_ || closed_.load();
+        }
+
+        // Wait until the channel can take count more items.
+        void wait_for_room(std::size_t count) {
+            if (has_room(count)) {
+                return;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int spin = 0; spin < kSpinLimit && !has_room(count); ++spin) {
+                std::this_thread::yield();
+            }
+            if (!has_room(count)) {
+                std::unique_lock<std::mutex> lock(mtx_);
+                producersWaiting_.fetch_add(1);
+                cv_not_full.wait(lock, [&] { return has_room(count); });
+                producersWaiting_.fetch_sub(1);
+            }
+            counters_.record_stall(std::chrono::steady_clock::now() - start);
+        }
+
+        // Give back room for count items and wake producers blocked on a full channel.
+        void release(std::size_t count) {
+            queued_.fetch_sub(count);
+            if (producersWaiting_.load() > 0) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                cv_not_full.notify_all();
+            }
+        }
+
+        std::atomic<Node*> head_{nullptr};
+        std::atomic<bool> closed_{false};
+        std::atomic<bool> consumerWaiting_{false};
+        std::mutex mtx_;
+        std::condition_variable cv_not_empty;
+
+        std::size_t capacity_;
+        std::atomic<std::size_t> queued_{0};          // items pushed but not yet popped
+        std::atomic<int> producersWaiting_{0};
+        std::condition_variable cv_not_full;
+        StallCounters counters_;
+};
+
+/**
+ * @class BatchChannel
+ *
+ * @brief A thread-safe multi-producer, single-consumer channel of item batches.
+ *
+ * @tparam T The type of elements stored in the channel.
+ *
+ * @details Batches from one producer are received in the order they were pushed.
+ * Batches from different producers may interleave in any order. Only one
+ * thread may call pop_batches(). A capacity of 0 (the default) means unbounded.
+ */
+template <typename T>
+class BatchChannel {
+    public:
+        explicit BatchChannel(std::size_t capacity = 0): channel_(capacity) {}
+
+        ~BatchChannel() {
+            Node* node = channel_.take_remaining();
+            while (node) {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+        // Disable copying
+        BatchChannel(const BatchChannel&) = delete;
+        BatchChannel& operator =(const BatchChannel&) = delete;
+
+        // Publish a whole batch with one atomic operation.
+        // Blocks while a bounded channel is at its high-water mark.
+        // Returns false if the channel is closed; true otherwise.
+        // An empty batch is accepted and ignored.
+        bool push_batch(std::vector<T>&& batch) {
+            if (batch.empty()) {
+                return true;
+            }
+            const std::size_t count = batch.size();
+            Node* node = new Node{std::move(batch), nullptr};
+            if (!channel_.push(node, count)) {
+                delete node;
+                return false;
+            }
+            return true;
+        }
+
+        // Take every batch published so far, oldest first, appending them to out.
+        // Blocks while the channel is empty and open.
+        // Returns false when the channel is closed and empty.
+        bool pop_batches(std::vector<std::vector<T>>& out) {
+            nodes_.clear();
+            if (!channel_.pop_all(nodes_, [](const Node& node) { return node.items.size(); })) {
+                return false;
+            }
+            for (Node* node : nodes_) {
+                out.push_back(std::move(node->items));
+                delete node;
+            }
+            return true;
+        }
+
+        // Close the channel. After this:
+        // - a waiting pop_batches wakes up and drains what is left
+        // - future pushes fail (return false)
+        void close() { channel_.close(); }
+
+        // Backpressure counters so far.
+        ChannelStats stats() const { return channel_.stats(); }
+
+    private:
+        struct Node {
+            std::vector<T> items;
+            Node* next;
+        };
+
+        IntrusiveChannel<Node> channel_;
+        std::vector<Node*> nodes_;   // consumer-side scratch list
+};
@@ -8,14 +8,70 @@
  * This channel provides thread-safe communication between multiple producers and consumers.
  * It supports blocking push and pop operations, and can be closed to signal no more data will be sent.
  * The goal to develop my own variation based on Professors.
+ * 
+ * A channel can optionally be bounded: once it holds `capacity` items, push blocks until the
+ * consumer catches up, so memory stays flat when the consumer is slower than the producers.
  */
 
  #pragma once
 
+ #include <atomic>
+ #include <chrono>
+ #include <cstddef>
  #include <queue>
  #include <mutex>
  #include <condition_variable>
 
+/**
+ * @struct ChannelStats
+ * 
+ * @brief Backpressure counters of a bounded channel.
+ * 
+ * @var stalls How many pushes had to wait for room.
+ * @var stallSeconds Total time producers spent waiting for room.
+ * @var peakQueued The largest number of items held at once.
+ */
+struct ChannelStats {
+    std::size_t stalls = 0;
+    double stallSeconds = 0.0;
+    std::size_t peakQueued = 0;
+};
+
+/**
+ * @class StallCounters
+ * 
+ * @brief Thread-safe accumulators behind ChannelStats, shared by the channel implementations.
+ */
+class StallCounters {
+    public:
+        void record_stall(std::chrono::steady_clock::duration waited) {
+            stalls_.fetch_add(1, std::memory_order_relaxed);
+            stallNanos_.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(),
+                std::memory_order_relaxed);
+        }
+
+        void record_size(std::size_t size) {
+            std::size_t peak = peak_.load(std::memory_order_relaxed);
+            while (size > peak &&
+                   !peak_.compare_exchange_weak(peak, size, std::memory_order_relaxed)) {
+            }
+        }
+
+        ChannelStats snapshot() const {
+            ChannelStats st;
+            st.stalls = stalls_.load(std::memory_order_relaxed);
+            st.stallSeconds = stallNanos_.load(std::memory_order_relaxed) / 1e9;
+            st.peakQueued = peak_.load(std::memory_order_relaxed);
+            return st;
+        }
+
+    private:
+        std::atomic<std::size_t> stalls_{0};
+        std::atomic<long long> stallNanos_{0};
+        std::atomic<std::size_t> peak_{0};
+};
+
 /**
  * @class Channel
  * 
@@ -27,34 +83,40 @@
  * 
  * @details This class uses a std::queue to store elements, protected by a mutex and condition variable.
  * It supports multiple producers and consumers, and allows the channel to be closed to signal no more data.
+ * A capacity of 0 (the default) means unbounded.
  */
 template <typename T>
 class Channel {
     public: 
-        Channel(): closed_(false) {}
+        explicit Channel(std::size_t capacity = 0): capacity_(capacity), closed_(false) {}
 
         // Disable copying
         Channel(const Channel&) = delete;
         Channel& operator =(const Channel&) = delete;
 
         // Push a value into the channel.
+        // Blocks while a bounded channel is full.
         // Returns false if the channel is closed; true otherwise
         bool push(const T& value) {
             std::unique_lock<std::mutex> lock(mtx_);
+            wait_for_room(lock);
             if (closed_) {
                 return false;
             }
             queue_.push(value);
+            counters_.record_size(queue_.size());
             cv_not_empty.notify_one();
             return true;
         }
 
         bool push(T&& value) {
             std::unique_lock<std::mutex> lock(mtx_);
+            wait_for_room(lock);
             if(closed_) {
                 return false;
             }
             queue_.push(std::move(value));
+            counters_.record_size(queue_.size());
             cv_not_empty.notify_one();
             return true;
         }
@@ -74,6 +136,9 @@ class Channel {
 
             out = std::move(queue_.front());
             queue_.pop();
+            if (capacity_ > 0) {
+                cv_not_full.notify_one();
+            }
             return true;
         }
 
@@ -84,11 +149,30 @@ class Channel {
             std::lock_guard<std::mutex> lock(mtx_);
             closed_ = true;
             cv_not_empty.notify_all();
+            cv_not_full.notify_all();
         }
+
+        // Backpressure counters so far.
+        ChannelStats stats() const { return counters_.snapshot(); }
     
     private:
+        // Wait until a bounded channel has room (or is closed); the caller holds the lock.
+        void wait_for_room(std::unique_lock<std::mutex>& lock) {
+            if (capacity_ == 0 || closed_ || queue_.size() < capacity_) {
+                return;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            cv_not_full.wait(lock, [&] {
+                return closed_ || queue_.size() < capacity_;
+            });
+            counters_.record_stall(std::chrono::steady_clock::now() - start);
+        }
+
         std::queue<T> queue_;
+        std::size_t capacity_;
         bool closed_;
         std::mutex mtx_;
         std::condition_variable cv_not_empty;
+        std::condition_variable cv_not_full;
+        StallCounters counters_;
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+/**
+ * @file include/checkpoint.h
+ *
+ * @brief Periodic checkpoints of a running search, and resuming from them.
+ *
+ * @section Overview
+ *
+ * A checkpoint is a snapshot of the search frontier: every unexplored part of the
+ * tree as a SearchTask, together with the counters and the output file offset at
+ * the moment the snapshot was taken. Everything before that offset was produced by
+ * the explored part of the tree, so a resumed run truncates the output file to the
+ * offset, seeds its pool with the saved tasks and produces every sequence exactly once.
+ *
+ * Checkpoint files are plain text:
+ *
+ *   NS1D0-CHECKPOINT 1
+ *   n <n>
+ *   symmetry <0|1>
+ *   count_only <0|1>
+ *   format <text|bytes|packed>
+ *   output_offset <bytes>
+ *   sequences <count>
+ *   nodes <count>
+ *   by_second <k> <count>...
+ *   tasks <k>
+ *   <first> <last> <prefix length> <prefix>...     (k lines)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @struct Checkpoint
+ *
+ * @brief The contents of a checkpoint file.
+ *
+ * @var n The modulus the search runs for.
+ * @var symmetry Whether the search only explores canonical sequences.
+ * @var countOnly Whether the search only counts sequences.
+ * @var format The output file format.
+ * @var outputOffset Length of the output file that belongs to the explored part.
+ * @var sequences Sequences found in the explored part.
+ * @var nodes Nodes expanded in the explored part.
+ * @var bySecond Per-second-element counts of a count-only run with a breakdown; empty otherwise.
+ * @var tasks The unexplored part of the tree.
+ */
+struct Checkpoint {
+    int n = 0;
+    bool symmetry = true;
+    bool countOnly = false;
+    SeqFormat format = SeqFormat::Text;
+    std::uint64_t outputOffset = 0;
+    std::size_t sequences = 0;
+    std::size_t nodes = 0;
+    std::vector<std::size_t> bySecond;
+    std::vector<SearchTask> tasks;
+};
+
+/**
+ * @brief Write a checkpoint file atomically (via a temporary file and rename).
+ *
+ * @param path The checkpoint file.
+ * @param cp The checkpoint to write.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was written.
+ */
+bool save_checkpoint(const std::string& path, const Checkpoint& cp, std::string& error);
+
+/**
+ * @brief Read a checkpoint file.
+ *
+ * @param path The checkpoint file.
+ * @param cp Receives the checkpoint.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was read and is well formed.
+ */
+bool load_checkpoint(const std::string& path, Checkpoint& cp, std::string& error);
+
+/**
+ * @class Checkpointer
+ *
+ * @brief Background thread that checkpoints a running search at a fixed interval.
+ *
+ * @details Each checkpoint pauses the pool, waits until the output thread has written
+ * every sequence the workers found so far, records the output offset and counters,
+ * resumes the workers and only then writes the file, so the pause is short.
+ */
+class Checkpointer {
+    public:
+        /**
+         * @param path The checkpoint file to keep up to date.
+         * @param intervalSeconds Time between checkpoints.
+         * @param base Header fields and the counters/offset the run started from.
+         * @param pool The pool the workers take tasks from.
+         * @param workerCounts The counters the workers report into.
+         * @param sequencesWritten Sequences the output thread has written in this run.
+         * @param writer The writer of the output file, or nullptr in count-only mode.
+         */
+        Checkpointer(std::string path,
+                     double intervalSeconds,
+                     Checkpoint base,
+                     WorkStealingPool& pool,
+                     const std::vector<SearchCounts>& workerCounts,
+                     const std::atomic<std::size_t>& sequencesWritten,
+                     SeqFileWriter* writer);
+
+        ~Checkpointer();
+
+        // Disable copying
+        Checkpointer(const Checkpointer&) = delete;
+        Checkpointer& operator =(const Checkpointer&) = delete;
+
+        void start();
+        void stop();
+
+        // Valid once stop() has returned; a checkpoint that could not be saved leaves the previous one in place
+        std::size_t checkpoints_written() const { return written_; }
+        std::size_t checkpoints_failed() const { return failed_; }
+        const std::string& last_error() const { return lastError_; }
+
+    private:
+        void run();
+        bool take();
+
+        std::string path_;
+        double intervalSeconds_;
+        Checkpoint base_;
+        WorkStealingPool& pool_;
+        const std::vector<SearchCounts>& workerCounts_;
+        const std::atomic<std::size_t>& sequencesWritten_;
+        SeqFileWriter* writer_;
+
+        std::thread thread_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::size_t written_ = 0;
+        std::size_t failed_ = 0;
+        std::string lastError_;
+};
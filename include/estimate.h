@@ -0,0 +1,122 @@
+/**
+ * @file include/estimate.h
+ *
+ * @brief Estimating the size of a search and its running time before committing to it.
+ *
+ * @section Overview
+ *
+ * estimate_search_tree() runs Knuth-style random probes below every second
+ * element. A probe walks from {0, a_1} towards a leaf, at every node expanding
+ * the children exactly as dfs_search() would: the same candidate masks, the
+ * same symmetry and lookahead cuts, the same state types. It picks one child it
+ * could descend into at random and multiplies its weight by how many there were.
+ * The weighted node and solution counts along the way are unbiased estimates of
+ * the subtree's totals; averaging many probes gives the estimate, and their
+ * spread the confidence interval.
+ *
+ * Probes say nothing about time, so sample_node_rate() runs the real search,
+ * count-only, on all workers for a short while and measures nodes per second.
+ * Dividing the estimated nodes by that rate predicts the wall time of a full run
+ * on the same machine with the same number of workers.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @brief Standard errors either side of an estimate that make a 95% confidence interval.
+ */
+constexpr double kConfidenceZ = 1.96;
+
+/**
+ * @struct SubtreeEstimate
+ *
+ * @brief The estimated size of the subtree below one second element.
+ *
+ * @var second The second element a_1.
+ * @var probes Probes run below it.
+ * @var nodes Estimated nodes expanded, counting {0, a_1} itself.
+ * @var nodesError Half-width of the 95% confidence interval of nodes.
+ * @var sequences Estimated sequences found, mirrors included when searching with symmetry.
+ * @var sequencesError Half-width of the 95% confidence interval of sequences.
+ */
+struct SubtreeEstimate {
+    int second = 0;
+    std::size_t probes = 0;
+    double nodes = 0.0;
+    double nodesError = 0.0;
+    double sequences = 0.0;
+    double sequencesError = 0.0;
+};
+
+/**
+ * @struct SearchEstimate
+ *
+ * @brief The estimated size of the whole search.
+ *
+ * @var subtrees One entry per initial search task, in the order of initial_search_tasks().
+ * @var nodes Estimated nodes expanded.
+ * @var nodesError Half-width of the 95% confidence interval of nodes.
+ * @var sequences Estimated sequences found.
+ * @var sequencesError Half-width of the 95% confidence interval of sequences.
+ * @var probeNodes Nodes the probes themselves expanded.
+ * @var probeSeconds Wall time of the probes.
+ */
+struct SearchEstimate {
+    std::vector<SubtreeEstimate> subtrees;
+    double nodes = 0.0;
+    double nodesError = 0.0;
+    double sequences = 0.0;
+    double sequencesError = 0.0;
+    std::size_t probeNodes = 0;
+    double probeSeconds = 0.0;
+};
+
+/**
+ * @struct NodeRate
+ *
+ * @brief What a short, real, count-only run measured.
+ *
+ * @var nodes Nodes expanded.
+ * @var sequences Sequences found.
+ * @var seconds Wall time of the run.
+ * @var complete True if the whole search fit in the time allowed, so nodes and sequences are exact.
+ */
+struct NodeRate {
+    std::size_t nodes = 0;
+    std::size_t sequences = 0;
+    double seconds = 0.0;
+    bool complete = false;
+};
+
+/**
+ * @brief Estimate the nodes and sequences of a search with random probes.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; symmetry, lookahead and the kernel choice shape the tree.
+ * @param probes Probes per second element.
+ * @param seed Seed of the random choices; the same seed gives the same estimate.
+ *
+ * @return SearchEstimate The estimates, per second element and in total.
+ */
+SearchEstimate estimate_search_tree(const NS1D0Config& cfg,
+                                    const SearchOptions& opts,
+                                    std::size_t probes,
+                                    std::uint64_t seed);
+
+/**
+ * @brief Measure the node rate of the real search on workerCount workers.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; the run is count-only whatever opts says.
+ * @param workerCount Number of worker threads.
+ * @param seconds How long to run before cancelling the search.
+ *
+ * @return NodeRate What the run did.
+ */
+NodeRate sample_node_rate(const NS1D0Config& cfg, const SearchOptions& opts, int workerCount, double seconds);
@@ -0,0 +1,265 @@
+/**
+ * @file include/fixed_search_state.h
+ *
+ * @brief SearchState specialized at compile time for one n, and the dispatch between the two.
+ *
+ * @details FixedSearchState<N> has the same interface as SearchState, but n, the
+ * sequence length and the forbidden value are constants, the masks are single
+ * 64-bit words and the Rule 5 partners and Rule 6 pairs come from constexpr
+ * tables instead of modulo arithmetic, so candidates() is a handful of word
+ * operations. The search code is written against either state type (see
+ * dfs_search), and with_search_state() picks the specialized one for the odd n
+ * in [kMinSpecializedN, kMaxSpecializedN] and the generic one otherwise.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "search_state.h"
+
+/**
+ * @brief The range of odd n that have a specialized search state.
+ */
+constexpr int kMinSpecializedN = 7;
+constexpr int kMaxSpecializedN = 31;
+
+/**
+ * @brief Whether with_search_state() has a specialized state for n.
+ */
+constexpr bool has_specialized_state(int n) {
+    return n >= kMinSpecializedN && n <= kMaxSpecializedN && n % 2 == 1;
+}
+
+/**
+ * @class FixedSearchState
+ *
+ * @brief The current prefix plus the bookkeeping needed to extend it, for a fixed n.
+ *
+ * @tparam N The modulus; odd and below 64 so every mask fits one word.
+ */
+template <int N>
+class FixedSearchState {
+        static_assert(N >= 3 && N % 2 == 1 && N < 64, "N must be odd and fit a 64-bit mask");
+
+        static constexpr int kLength = (N - 1) / 2 + 1;
+        static constexpr int kForbidden = (N + 1) / 2;
+
+        // partner[v] = (1 - v) mod N; pair[d + N - 1] = min(d mod N, -d mod N) for d in (-N, N)
+        struct Tables {
+            std::array<int, N> partner{};
+            std::array<int, 2 * N - 1> pair{};
+        };
+
+        static constexpr Tables make_tables() {
+            Tables t;
+            for (int v = 0; v < N; ++v) {
+                t.partner[v] = (N + 1 - v) % N;
+            }
+            for (int d = -(N - 1); d <= N - 1; ++d) {
+                const int r = (d % N + N) % N;
+                t.pair[d + N - 1] = r <= N - r ? r : N - r;
+            }
+            return t;
+        }
+
+        static constexpr Tables kTables = make_tables();
+
+        static constexpr std::uint64_t bit(int i) { return std::uint64_t{1} << i; }
+
+        static constexpr std::uint64_t kAllValues = bit(N) - 1;
+        static constexpr std::uint64_t kAllDiffs = kAllValues & ~bit(0);
+
+    public:
+        /**
+         * @class Candidates
+         *
+         * @brief The valid next values of a node, iterated in increasing order.
+         */
+        class Candidates {
+            public:
+                explicit Candidates(std::uint64_t bits): bits_(bits) {}
+
+                // Take the next value; false once there are none left.
+                bool next(int& v) {
+                    if (bits_ == 0) return false;
+                    v = __builtin_ctzll(bits_);
+                    bits_ &= bits_ - 1;
+                    return true;
+                }
+
+            private:
+                std::uint64_t bits_;
+        };
+
+        explicit FixedSearchState(const NS1D0Config& cfg): cfg_(cfg) {
+            seq_.reserve(kLength);
+        }
+
+        // Check whether appending v keeps the prefix valid (Rules 1-6).
+        bool can_push(int v) const { return check(v) == PruneReason::None; }
+
+        // Like can_push(), but say which rule rejects v.
+        PruneReason check(int v) const {
+            const int size = static_cast<int>(seq_.size());
+            if (size >= kLength) return PruneReason::Length;                 // Rule 1
+            if (v < 0 || v >= N) return PruneReason::Range;                  // range
+            if (size == 0) return v == 0 ? PruneReason::None : PruneReason::Start; // Rule 2
+            if (used_ & bit(v)) return PruneReason::Unique;                  // unique
+            if ((v == 1) != (size + 1 == kLength)) {
+                return PruneReason::OneAtEnd;                                // Rule 3
+            }
+            if (v == kForbidden) return PruneReason::Forbidden;              // Rule 4
+            if (excluded_ & bit(v)) return PruneReason::PairExclusion;       // Rule 5
+            if (usedPair_ & bit(pair_of(v - seq_.back()))) {
+                return PruneReason::DifferencePair;                          // Rule 6
+            }
+            return PruneReason::None;
+        }
+
+        // The valid next values from first on (Rules 1-6).
+        Candidates candidates(int first) const {
+            const int size = static_cast<int>(seq_.size());
+            if (size >= kLength) return Candidates(0);                      // Rule 1
+            if (size == 0) return Candidates(first <= 0 ? bit(0) : 0);      // Rule 2
+
+            // Value v is reachable through difference v - last, i.e. the free differences rotated by last
+            const int last = seq_.back();
+            const std::uint64_t reachable = rotate(freeDiffs_, last);
+
+            std::uint64_t bits = reachable & ~used_ & ~excluded_ & ~bit(kForbidden);  // Rules 4-6
+            bits &= size + 1 == kLength ? bit(1) : ~bit(1);                          // Rule 3
+            bits &= ~(bit(first) - 1);
+            return Candidates(bits);
+        }
+
+        // Append v. The caller must have checked can_push(v).
+        void push(int v) {
+            if (!seq_.empty()) {
+                const int p = pair_of(v - seq_.back());
+                usedPair_ |= bit(p);
+                freeDiffs_ &= ~(bit(p) | bit(N - p));
+            }
+            used_ |= bit(v);
+            if (v >= 2) {
+                excluded_ |= bit(kTables.partner[v]);
+            }
+            seq_.push_back(v);
+        }
+
+        // Remove the last element, undoing everything push() recorded.
+        void pop() {
+            const int v = seq_.back();
+            seq_.pop_back();
+            if (v >= 2) {
+                excluded_ &= ~bit(kTables.partner[v]);
+            }
+            used_ &= ~bit(v);
+            if (!seq_.empty()) {
+                const int p = pair_of(v - seq_.back());
+                usedPair_ &= ~bit(p);
+                freeDiffs_ |= bit(p) | bit(N - p);
+            }
+        }
+
+        // See SearchState::canonical_possible().
+        bool canonical_possible() const {
+            if (seq_.size() < 2) return true;
+            constexpr std::uint64_t kAllPairs = bit(N / 2 + 1) - 1;
+            const std::uint64_t above = kAllPairs & ~(bit(pair_of(seq_[1] - seq_[0]) + 1) - 1);
+            return (above & ~usedPair_) != 0;
+        }
+
+        // See SearchState::lookahead().
+        PruneReason lookahead() const {
+            const int remaining = kLength - static_cast<int>(seq_.size());
+            const int last = seq_.back();
+            if (remaining == 1) {
+                return (freeDiffs_ & bit(kTables.partner[last])) ? PruneReason::None : PruneReason::FinalStep;
+            }
+
+            const std::uint64_t available = kAllValues & ~used_ & ~excluded_ & ~bit(kForbidden) & ~bit(1);
+            std::uint64_t beforeOne = available & rotate(freeDiffs_, 1);
+            if (remaining == 2) {
+                beforeOne &= rotate(freeDiffs_, last);
+            }
+            if (beforeOne == 0) {
+                return PruneReason::FinalStep;
+            }
+
+            const std::uint64_t reach = available | bit(1) | bit(last);
+            constexpr std::uint64_t kAllPairs = (bit(N / 2 + 1) - 1) & ~bit(0);
+            for (std::uint64_t free = kAllPairs & ~usedPair_; free != 0; free &= free - 1) {
+                if ((reach & rotate(reach, __builtin_ctzll(free))) == 0) {
+                    return PruneReason::PairCoverage;
+                }
+            }
+            return PruneReason::None;
+        }
+
+        // Write the symmetric partner (1 - a_{k-1-i}) mod n of the current sequence to out.
+        void mirror(std::vector<int>& out) const {
+            out.resize(seq_.size());
+            for (std::size_t i = 0; i < seq_.size(); ++i) {
+                out[i] = kTables.partner[seq_[seq_.size() - 1 - i]];
+            }
+        }
+
+        bool contains(int v) const { return (used_ & bit(v)) != 0; }
+        bool complete() const { return static_cast<int>(seq_.size()) == kLength; }
+        int size() const { return static_cast<int>(seq_.size()); }
+        const std::vector<int>& sequence() const { return seq_; }
+        const NS1D0Config& config() const { return cfg_; }
+
+        static constexpr int n() { return N; }
+        static constexpr int length() { return kLength; }
+
+    private:
+        static constexpr int pair_of(int diff) { return kTables.pair[diff + N - 1]; }
+
+        // Rotate a mask of N bits left by s, 0 <= s < N.
+        static constexpr std::uint64_t rotate(std::uint64_t bits, int s) {
+            return ((bits << s) | (bits >> (N - s))) & kAllValues;
+        }
+
+        const NS1D0Config& cfg_;
+        std::vector<int> seq_;
+        std::uint64_t used_ = 0;       // values already in the sequence
+        std::uint64_t excluded_ = 0;   // values whose (1 - x) partner is in the sequence
+        std::uint64_t usedPair_ = 0;   // difference pairs already taken
+        std::uint64_t freeDiffs_ = kAllDiffs;  // differences d in [1, N) whose pair is still free
+};
+
+/**
+ * @brief Names a state type for with_search_state() callbacks: use typename decltype(tag)::type.
+ */
+template <typename State>
+struct StateTag {
+    using type = State;
+};
+
+/**
+ * @brief Call f with the tag of the best state type for n.
+ *
+ * @param n The modulus.
+ * @param specialized Use FixedSearchState when there is one for n; otherwise always SearchState.
+ * @param f Callable taking a StateTag.
+ *
+ * @return void
+ */
+template <typename F, int N = kMinSpecializedN>
+void with_search_state(int n, bool specialized, F&& f) {
+    if constexpr (N > kMaxSpecializedN) {
+        (void)n;
+        (void)specialized;
+        f(StateTag<SearchState>{});
+    } else {
+        if (specialized && n == N) {
+            f(StateTag<FixedSearchState<N>>{});
+        } else {
+            with_search_state<F, N + 2>(n, specialized, std::forward<F>(f));
+        }
+    }
+}
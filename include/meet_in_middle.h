@@ -0,0 +1,78 @@
+/**
+ * @file include/meet_in_middle.h
+ *
+ * @brief Meet-in-the-middle search: join left halves from 0 with right halves ending at 1.
+ *
+ * @section Overview
+ *
+ * Every sequence a_0..a_{k-1} starts at 0 and ends at 1, so it can be cut at the
+ * middle element a_m into a left half a_0..a_m and a right half a_m..a_{k-1}.
+ * The mirror map x -> (1 - x) mod n, read backwards, turns a right half into a
+ * valid prefix (0, ...) of length k - m, so both halves are enumerated by the
+ * ordinary depth-first search, cut off at half depth.
+ *
+ * Each sequence uses every difference pair exactly once (Rule 6) and, besides 0
+ * and 1, exactly one value of every partner class {x, 1 - x} (uniqueness and
+ * Rule 5). So a right half fits exactly the left halves that end at its first
+ * element, use the complement of its pairs and cover the complement of its
+ * classes. The left halves are indexed by that key and every right half looks
+ * up its complement: each match is a sequence, no further checks needed.
+ *
+ * The index is built per partition, i.e. per second element a_1, under a memory
+ * cap. Partitions that do not fit are handed back as ordinary search tasks, to be
+ * searched depth-first with symmetry breaking off. The join itself never uses
+ * symmetry: it finds every sequence of the partitions it covers directly.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @brief The largest n the meet-in-the-middle engine handles; value masks are single 64-bit words.
+ */
+constexpr int kMaxMeetInMiddleN = 63;
+
+/**
+ * @struct MeetInMiddleStats
+ *
+ * @brief What the meet-in-the-middle engine did.
+ *
+ * @var leftHalves Left halves stored in the index.
+ * @var rightHalves Right halves looked up in the index.
+ * @var indexBytes Memory held by the index.
+ * @var partitionsJoined Partitions (second elements) found by joining.
+ * @var partitionsFallback Partitions left to the depth-first search.
+ */
+struct MeetInMiddleStats {
+    std::size_t leftHalves = 0;
+    std::size_t rightHalves = 0;
+    std::size_t indexBytes = 0;
+    int partitionsJoined = 0;
+    int partitionsFallback = 0;
+};
+
+/**
+ * @brief Find every sequence of the partitions whose halves fit in memory by joining halves.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; symmetry is ignored.
+ * @param memoryLimit Bytes the index of left halves may use.
+ * @param workerCount Number of threads to build the index and run the join with.
+ * @param resultChannel Channel to send the sequences found, encoded in opts.format; unused in count-only mode.
+ * @param counts Receives the nodes of both half searches and the sequences found.
+ * @param stats Receives what the engine did.
+ *
+ * @return std::vector<SearchTask> The partitions left to the depth-first search, which must
+ * search them with symmetry breaking off.
+ */
+std::vector<SearchTask> meet_in_middle_search(const NS1D0Config& cfg,
+                                              const SearchOptions& opts,
+                                              std::size_t memoryLimit,
+                                              int workerCount,
+                                              ResultChannel& resultChannel,
+                                              SearchCounts& counts,
+                                              MeetInMiddleStats& stats);
@@ -13,7 +13,14 @@
 
 #include <vector>
 #include <atomic>
-#include "channel.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include "result_slab.h"
+#include "work_stealing.h"
+#include "seqfile.h"
+#include "search_stats.h"
 
 /**
  * @struct NS1D0Config
@@ -33,6 +40,128 @@ struct NS1D0Config {
     int forbidden;      // ceil(n/2), which cannot appear
 };
 
+/**
+ * @brief Receives a sequence found by a worker, on that worker's thread.
+ * 
+ * @details seq points into the worker's own state and is only valid during the call.
+ * Return false to cancel the search.
+ */
+using ResultCallback = std::function<bool(const int* seq, std::size_t length)>;
+
+/**
+ * @struct SearchOptions
+ * 
+ * @brief Knobs that change how the search runs but not what it finds.
+ * 
+ * @var symmetry Explore only the canonical member of each mirror pair and emit the other one for free.
+ * @var countOnly Only count sequences; nothing is sent to the result channel.
+ * @var breakdown In count-only mode, also count sequences per second element.
+ * @var specialized Use the search kernel compiled for this n, if there is one (see fixed_search_state.h).
+ * @var lookahead Prune prefixes that provably cannot be completed (see SearchState::lookahead()).
+ * @var format The output format workers encode their results in before sending them.
+ * @var ordered Tag results with their task so the output can be written in lexicographic order (see reorder.h).
+ * @var resultBatch Sequences a worker collects before publishing them, at most kResultBatchSize; smaller batches reach the output sooner.
+ * @var onResult If set, workers hand every sequence to it instead of publishing or tallying it (see ns1d0_api.h).
+ */
+struct SearchOptions {
+    bool symmetry = true;
+    bool countOnly = false;
+    bool breakdown = false;
+    bool specialized = true;
+    bool lookahead = true;
+    SeqFormat format = SeqFormat::Text;
+    bool ordered = false;
+    std::size_t resultBatch = kResultBatchSize;
+    ResultCallback onResult;
+};
+
+/**
+ * @class ResultBatcher
+ * 
+ * @brief Encodes one worker's results and publishes them in slabs of kResultBatchSize sequences.
+ * 
+ * @details Formatting happens here, in the worker, so the output thread only copies bytes.
+ * The slabs come from the batcher's own pool and are recycled once written.
+ * In ordered mode the slabs are also tagged with the running task, and the batcher
+ * tells the output thread about tasks split off and finished.
+ */
+class ResultBatcher {
+    public:
+        ResultBatcher(ResultChannel& channel, SeqFormat format, int n, int length, bool ordered = false,
+                      std::size_t batch = kResultBatchSize);
+
+        // Start tagging results with a task's order key (ordered mode only).
+        void begin_task(const SearchTask& task);
+
+        // Publish the pending sequences and, in ordered mode, report the running task as done.
+        void end_task();
+
+        // Tell the output thread about a task split off the running one (ordered mode only).
+        void announce(const SearchTask& task);
+
+        // Encode one sequence of the encoder's length, publishing the slab when it is full.
+        void add(const int* seq) {
+            encoder_.encode(seq, slab_->bytes);
+            if (++slab_->count >= batch_) {
+                flush();
+            }
+        }
+
+        // Publish the pending sequences, if any.
+        void flush();
+
+    private:
+        void publish();
+
+        ResultChannel& channel_;
+        SlabPool& pool_;
+        SeqEncoder encoder_;
+        bool ordered_;
+        std::size_t batch_;
+        std::vector<int> taskKey_;   // order key of the running task, in ordered mode
+        ResultSlab* slab_;
+};
+
+/**
+ * @struct SearchCounts
+ * 
+ * @brief Counters gathered by one worker.
+ * 
+ * @var nodes Number of nodes expanded.
+ * @var sequences Number of valid sequences found.
+ * @var bySecond Sequences per second element, indexed by that element; only filled in count-only mode with a breakdown.
+ * @var explored Fraction of the search tree finished, with every candidate of a node weighted equally.
+ * @var finalStepPruned Prefixes the lookahead cut because nothing could step into the final 1.
+ * @var pairCoveragePruned Prefixes the lookahead cut because a free difference pair could not be used.
+ * @var stats Per-rule, per-depth counters; empty unless built with NS1D0_STATS.
+ */
+struct SearchCounts {
+    std::size_t nodes = 0;
+    std::size_t sequences = 0;
+    std::vector<std::size_t> bySecond;
+    double explored = 0.0;
+    std::size_t finalStepPruned = 0;
+    std::size_t pairCoveragePruned = 0;
+    SearchStats stats;
+};
+
+/**
+ * @name Individual rule checks
+ * 
+ * @brief The rules is_valid_prefix() applies, one function each. See src/ns1d0.cpp for details.
+ * 
+ * @details Exposed so the rules can be benchmarked in isolation (bench/kernel_bench.cpp).
+ * @{
+ */
+bool rule1_length(const std::vector<int>& seq, const NS1D0Config& cfg);
+bool rule_unique_and_in_range(const std::vector<int>& seq, const NS1D0Config& cfg);
+bool rule2_starts_with_zero(const std::vector<int>& seq);
+bool rule3_one_at_end(const std::vector<int>& seq, const NS1D0Config& cfg);
+bool rule4_no_forbidden(const std::vector<int>& seq, const NS1D0Config& cfg);
+bool rule5_pair_exclusion(const std::vector<int>& seq, const NS1D0Config& cfg);
+bool rule6_differences_unique_pairs(const std::vector<int>& seq, const NS1D0Config& cfg);
+/** @} */
+
 /**
  * @brief Check whether a *prefix* of a sequence is valid so far.
  * 
@@ -45,40 +174,132 @@ struct NS1D0Config {
  */
 bool is_valid_prefix(const std::vector<int>& seq, const NS1D0Config& cfg);
 
+/**
+ * @brief The initial search tasks, one per possible second element.
+ * 
+ * @param cfg Configuration containing the target length and other parameters.
+ * 
+ * @return std::vector<SearchTask> The tasks that together cover the whole search tree.
+ */
+std::vector<SearchTask> initial_search_tasks(const NS1D0Config& cfg);
+
+/**
+ * @brief The number of worker threads to run; bin/sequence and ns1d0_search() share this default.
+ * 
+ * @param requested The number asked for; 0 to pick one.
+ * 
+ * @return int requested if given, otherwise one per hardware thread (4 if that is unknown), and at least 2.
+ */
+int worker_count(int requested);
+
+/**
+ * @brief The share of the search tree a task covers, weighting every candidate of a node equally.
+ * 
+ * @param task The task.
+ * @param cfg Configuration containing the target length and other parameters.
+ * 
+ * @return double The task's fraction of the tree; the fractions of disjoint tasks add up.
+ */
+double task_weight(const SearchTask& task, const NS1D0Config& cfg);
+
 /**
  * @brief Worker function for searching valid sequences.
  * 
  * @param workerIndex The index of this worker thread.
- * @param workerCount The total number of worker threads.
+ * @param pool The pool to take search tasks from.
  * @param cfg Configuration containing the target length and other parameters.
- * @param resultChannel Channel to send valid sequences found.  
+ * @param opts Search options.
+ * @param resultChannel Channel to send the valid sequences found, encoded in opts.format; unused in count-only mode.
+ * @param counts Receives this worker's counters after every task, at checkpoints and at the end.
  * @param nodesExpanded Atomic counter for the number of nodes expanded during the search.
+ * @param live Where this worker publishes its progress while the search runs.
  * 
  * @return void
  * 
  * @details This function is executed by each worker thread to search for valid sequences. 
+ * Workers split their subtree whenever another worker is idle, so the load stays balanced.
  */
 void search_worker(
     int workerIndex,
-    int workerCount,
+    WorkStealingPool& pool,
     const NS1D0Config& cfg,
-    Channel<std::vector<int>>& resultChannel,
-    std::atomic<std::size_t>& nodesExpanded
+    const SearchOptions& opts,
+    ResultChannel& resultChannel,
+    SearchCounts& counts,
+    std::atomic<std::size_t>& nodesExpanded,
+    LiveProgress& live
 );
 
+/**
+ * @struct SearchJob
+ * 
+ * @brief One n of a sweep: what its workers need, and what they hand back.
+ * 
+ * @var cfg Configuration of this n.
+ * @var opts Search options for this n.
+ * @var channel Where the results go; needed even in count-only mode, where nothing is sent.
+ * @var counts Per-worker counters, as search_worker() reports them.
+ * @var live Per-worker progress, as search_worker() publishes it.
+ * @var nodes Nodes expanded, added up by the workers as they finish.
+ * @var pending Tasks of this job queued or running; set to the initial task count before the workers start.
+ * @var finished When pending dropped to 0; only valid once it has.
+ * 
+ * @details The worker that finishes the job's last task closes the channel, so the
+ * job's output can be completed while other jobs are still running.
+ */
+struct SearchJob {
+    NS1D0Config cfg;
+    SearchOptions opts;
+    ResultChannel* channel = nullptr;
+    std::vector<SearchCounts> counts;
+    std::vector<LiveProgress> live;
+    std::atomic<std::size_t> nodes{0};
+    std::atomic<std::size_t> pending{0};
+    std::chrono::steady_clock::time_point finished;
+};
+
+/**
+ * @brief Worker function for a sweep: runs the tasks of several searches from one shared pool.
+ * 
+ * @param workerIndex The index of this worker thread.
+ * @param pool The pool to take search tasks from; SearchTask::job indexes jobs.
+ * @param jobs The searches; each needs counts and live sized for the pool's workers.
+ * 
+ * @return void
+ * 
+ * @details The worker keeps one search context per job it has run a task of, so every n
+ * runs on its own state type and result batcher.
+ */
+void sweep_worker(int workerIndex, WorkStealingPool& pool, std::deque<SearchJob>& jobs);
+
+/**
+ * @struct OutputLimit
+ * 
+ * @brief A cap on the sequences written, for first-k and existence queries.
+ * 
+ * @var sequences Write at most this many sequences; 0 for no cap.
+ * @var pool Cancelled by the output thread once the cap is reached, which stops every worker.
+ */
+struct OutputLimit {
+    std::size_t sequences = 0;
+    WorkStealingPool* pool = nullptr;
+};
+
 /**
  * @brief Thread function for outputting valid sequences.
  * 
- * @param resultChannel Channel from which to receive valid sequences.
- * @param out Output stream to write the sequences.
+ * @param resultChannel Channel from which to receive the encoded sequences.
+ * @param writer Writer of the output file; flushed once the channel is closed and drained.
  * @param sequencesFound Atomic counter for the number of sequences found.
+ * @param limit Stop writing, and cancel the search, after this many sequences.
  * 
  * @return void
  * 
  * @details This function runs in a separate thread to output valid sequences as they are found.
  */
 void output_thread(
-    Channel<std::vector<int>>& resultChannel,
-    std::ostream& out,
-    std::atomic<std::size_t>& sequencesFound
+    ResultChannel& resultChannel,
+    SeqFileWriter& writer,
+    std::atomic<std::size_t>& sequencesFound,
+    const OutputLimit& limit
 );
\ No newline at end of file
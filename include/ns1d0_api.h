@@ -0,0 +1,181 @@
+/**
+ * @file include/ns1d0_api.h
+ *
+ * @brief The embeddable interface of libns1d0: search in-process, with a callback or a generator.
+ *
+ * @section Overview
+ *
+ * ns1d0_search() runs the parallel search and hands every sequence to a callback
+ * on the worker thread that found it. The callback sees a SequenceView into the
+ * worker's own storage, so nothing is copied or queued; it must be thread-safe
+ * and must copy what it wants to keep. Returning false from it, reaching the
+ * limit or setting the cancel flag stops the search early.
+ *
+ * NS1D0Generator turns the same search around: it runs in the background and
+ * next() pulls one sequence at a time. Workers block when the consumer falls
+ * capacity sequences behind, so a slow consumer slows the search down instead of
+ * using memory.
+ *
+ *   NS1D0Generator gen(21, {});
+ *   for (const std::vector<int>& seq : gen) { ... }
+ *
+ * The bin/sequence tool is built on the same library; it uses the lower-level
+ * pieces (ns1d0.h, work_stealing.h) for what only a file writer needs, such as
+ * checkpoints and ordered output.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "channel.h"
+#include "ns1d0.h"
+
+/**
+ * @struct SequenceView
+ *
+ * @brief A found sequence, pointing into the storage of the worker that found it.
+ *
+ * @var data The elements.
+ * @var size Number of elements.
+ */
+struct SequenceView {
+    const int* data;
+    std::size_t size;
+
+    const int* begin() const { return data; }
+    const int* end() const { return data + size; }
+    int operator [](std::size_t i) const { return data[i]; }
+};
+
+/**
+ * @struct NS1D0SearchOptions
+ *
+ * @brief How ns1d0_search() runs.
+ *
+ * @var threads Worker threads; 0 for the default of bin/sequence, see worker_count().
+ * @var limit Stop after this many sequences; 0 for all of them.
+ * @var cancel Set it from any thread to stop the search; checked every millisecond or so. May be null.
+ * @var search Symmetry breaking, lookahead and kernel choice; the output settings are ignored.
+ */
+struct NS1D0SearchOptions {
+    int threads = 0;
+    std::size_t limit = 0;
+    const std::atomic<bool>* cancel = nullptr;
+    SearchOptions search;
+};
+
+/**
+ * @struct NS1D0SearchResult
+ *
+ * @brief What ns1d0_search() did.
+ *
+ * @var sequences Sequences handed to the callback.
+ * @var nodes Nodes expanded.
+ * @var complete True if the whole search tree was explored; false if the search was stopped.
+ * @var seconds Wall time of the search.
+ */
+struct NS1D0SearchResult {
+    std::size_t sequences = 0;
+    std::size_t nodes = 0;
+    bool complete = false;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Receives each sequence; called concurrently from the worker threads. Return false to stop.
+ */
+using NS1D0Callback = std::function<bool(SequenceView)>;
+
+/**
+ * @brief The configuration of NS1D0(n).
+ *
+ * @param n An odd modulus greater than 1.
+ *
+ * @return NS1D0Config The length and forbidden value that go with n.
+ */
+NS1D0Config ns1d0_config(int n);
+
+/**
+ * @brief Find the sequences of NS1D0(n) and hand each one to a callback.
+ *
+ * @param n An odd modulus greater than 1.
+ * @param options Threads, limit, cancellation and search knobs.
+ * @param callback Receives the sequences, on the worker threads.
+ *
+ * @return NS1D0SearchResult What was searched and found.
+ */
+NS1D0SearchResult ns1d0_search(int n, const NS1D0SearchOptions& options, const NS1D0Callback& callback);
+
+/**
+ * @class NS1D0Generator
+ *
+ * @brief Pull-style access to the sequences of NS1D0(n), searched in the background.
+ *
+ * @details The search starts in the constructor. Destroying the generator, or
+ * calling stop(), cancels whatever is left of it. options.cancel is replaced by the
+ * generator's own flag.
+ */
+class NS1D0Generator {
+    public:
+        // Default number of sequences the workers may run ahead of the consumer.
+        static constexpr std::size_t kDefaultCapacity = 4096;
+
+        NS1D0Generator(int n, NS1D0SearchOptions options, std::size_t capacity = kDefaultCapacity);
+        ~NS1D0Generator();
+
+        // Disable copying
+        NS1D0Generator(const NS1D0Generator&) = delete;
+        NS1D0Generator& operator =(const NS1D0Generator&) = delete;
+
+        // Take the next sequence; blocks until there is one. Returns false once the search is over.
+        bool next(std::vector<int>& out);
+
+        // Cancel the search; next() still returns what was already queued.
+        void stop();
+
+        // What the search did; complete only after next() returned false.
+        const NS1D0SearchResult& result() const { return result_; }
+
+        /**
+         * @brief Input iterator over the remaining sequences, for range-based for loops.
+         */
+        class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = std::vector<int>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const std::vector<int>*;
+                using reference = const std::vector<int>&;
+
+                iterator() = default;
+                explicit iterator(NS1D0Generator* gen): gen_(gen) { ++*this; }
+
+                reference operator *() const { return current_; }
+                pointer operator ->() const { return &current_; }
+                iterator& operator ++() {
+                    if (gen_ && !gen_->next(current_)) gen_ = nullptr;
+                    return *this;
+                }
+                bool operator ==(const iterator& other) const { return gen_ == other.gen_; }
+                bool operator !=(const iterator& other) const { return gen_ != other.gen_; }
+
+            private:
+                NS1D0Generator* gen_ = nullptr;
+                std::vector<int> current_;
+        };
+
+        iterator begin() { return iterator(this); }
+        iterator end() { return iterator(); }
+
+    private:
+        Channel<std::vector<int>> channel_;
+        std::atomic<bool> cancel_{false};
+        NS1D0SearchResult result_;
+        std::thread thread_;
+};
@@ -0,0 +1,105 @@
+/**
+ * @file include/pair_search.h
+ *
+ * @brief A second search engine that branches on difference pairs and grows the sequence from both ends.
+ *
+ * @section Overview
+ *
+ * A sequence has k = (n - 1) / 2 + 1 elements and so k - 1 differences, and
+ * Rule 6 allows each pair {j, n - j} at most once. There are exactly (n - 1) / 2
+ * pairs, so every pair is used exactly once, with one of its two signs: a
+ * sequence is a signed permutation of the pairs whose prefix sums are distinct,
+ * avoid the forbidden value and the partner of every value already used, and end
+ * at 1.
+ *
+ * Both ends of that walk are known: it starts at 0 and ends at 1. The engine
+ * keeps a left end L (grown from 0) and a right end R (grown backwards from 1).
+ * A step picks an unused pair and a sign and extends one end by it:
+ *
+ *     L' = L + s j    or    R' = R - s j    (mod n)
+ *
+ * At every node it computes the candidates of both ends, with the same masks as
+ * SearchState (the unused differences rotated to the end, minus the blocked
+ * values), and branches on the end with fewer of them: most constrained first.
+ * An end with no candidates left ends the node at once. Once every value between
+ * 0 and 1 is placed, the one pair left must be exactly the gap R - L; that check
+ * replaces the last step.
+ *
+ * Tasks reuse SearchTask: prefix holds the values placed so far, in the order the
+ * engine placed them. The end each one went to is not stored, because replaying
+ * the prefix chooses the same ends again. The node count is the number of values
+ * placed, so it is not directly comparable with dfs_search(), which also counts
+ * the final 1 as a node.
+ *
+ * The engine finds every sequence directly and ignores symmetry breaking, the
+ * lookahead and the specialized kernels. The masks are single 64-bit words, so n
+ * is limited to kMaxPairSearchN.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @brief The largest n the difference-pair engine handles; value masks are single 64-bit words.
+ */
+constexpr int kMaxPairSearchN = 63;
+
+/**
+ * @brief The search engines bin/sequence can run.
+ */
+enum class SearchEngine {
+    Dfs,    // dfs_search(): one element at a time, from 0 towards 1
+    Pairs   // pair_search_worker(): one difference pair at a time, at the more constrained end
+};
+
+/**
+ * @brief Parse an engine name ("dfs" or "pairs").
+ *
+ * @param name The name to parse.
+ * @param out Receives the engine.
+ *
+ * @return true If the name is known.
+ */
+bool parse_search_engine(const std::string& name, SearchEngine& out);
+
+/**
+ * @brief The initial tasks of the difference-pair engine, one per candidate of the root.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ *
+ * @return std::vector<SearchTask> The tasks that together cover the whole search.
+ */
+std::vector<SearchTask> initial_pair_tasks(const NS1D0Config& cfg);
+
+/**
+ * @brief Worker function of the difference-pair engine.
+ *
+ * @param workerIndex The index of this worker thread.
+ * @param pool The pool to take search tasks from; seed it with initial_pair_tasks().
+ * @param cfg Configuration containing the target length and other parameters; n <= kMaxPairSearchN.
+ * @param opts Search options; symmetry, lookahead, specialized and ordered are ignored.
+ * @param resultChannel Channel to send the valid sequences found, encoded in opts.format; unused in count-only mode.
+ * @param counts Receives this worker's counters after every task and at the end.
+ * @param nodesExpanded Atomic counter for the number of nodes expanded during the search.
+ * @param live Where this worker publishes its progress while the search runs.
+ *
+ * @return void
+ *
+ * @details A drop-in for search_worker(): workers split their subtree whenever another
+ * worker is idle, and stop when the pool is cancelled. Checkpoints are not supported.
+ */
+void pair_search_worker(
+    int workerIndex,
+    WorkStealingPool& pool,
+    const NS1D0Config& cfg,
+    const SearchOptions& opts,
+    ResultChannel& resultChannel,
+    SearchCounts& counts,
+    std::atomic<std::size_t>& nodesExpanded,
+    LiveProgress& live
+);
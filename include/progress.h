@@ -0,0 +1,122 @@
+/**
+ * @file include/progress.h
+ *
+ * @brief Live progress reports while the search runs, and the JSON summary of a finished run.
+ *
+ * @section Overview
+ *
+ * The ProgressReporter thread wakes up at a fixed interval, sums the workers'
+ * LiveProgress counters and prints one line with the node and solution rates and
+ * an estimated time to completion. The estimate assumes the unexplored part of
+ * the tree costs as much per unit of weight as the explored part did (see
+ * task_weight()), so it is rough early on and improves as the search proceeds.
+ *
+ * write_stats_json() dumps the totals, the per-worker counters and, when built
+ * with NS1D0_STATS, the per-depth, per-rule counters as one JSON object.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @class ProgressReporter
+ *
+ * @brief Background thread that prints progress lines at a fixed interval.
+ */
+class ProgressReporter {
+    public:
+        /**
+         * @param intervalSeconds Time between reports.
+         * @param live The workers' live counters.
+         * @param baseExplored Fraction of the tree already finished when the run started.
+         * @param baseSequences Sequences already found when the run started.
+         * @param out Where to print the reports.
+         */
+        ProgressReporter(double intervalSeconds,
+                         const std::vector<LiveProgress>& live,
+                         double baseExplored,
+                         std::size_t baseSequences,
+                         std::ostream& out);
+
+        ~ProgressReporter();
+
+        // Disable copying
+        ProgressReporter(const ProgressReporter&) = delete;
+        ProgressReporter& operator =(const ProgressReporter&) = delete;
+
+        void start();
+        void stop();
+
+    private:
+        void run();
+        void report();
+
+        using Clock = std::chrono::steady_clock;
+
+        double intervalSeconds_;
+        const std::vector<LiveProgress>& live_;
+        double baseExplored_;
+        std::size_t baseSequences_;
+        std::ostream& out_;
+
+        Clock::time_point start_;
+        std::size_t lastNodes_ = 0;
+        std::size_t lastSequences_ = 0;
+        Clock::time_point last_;
+
+        std::thread thread_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+};
+
+/**
+ * @struct RunSummary
+ *
+ * @brief Everything write_stats_json() reports about a finished run.
+ *
+ * @var n The modulus searched.
+ * @var symmetry Whether only canonical sequences were searched.
+ * @var seconds Wall-clock time of the search.
+ * @var total The merged counters, including those of a resumed checkpoint.
+ * @var workers Each worker's counters for this run.
+ * @var workerStats Each worker's scheduling counters.
+ */
+struct RunSummary {
+    int n = 0;
+    bool symmetry = true;
+    double seconds = 0.0;
+    SearchCounts total;
+    std::vector<SearchCounts> workers;
+    std::vector<WorkerStats> workerStats;
+};
+
+/**
+ * @brief Write a run summary as JSON.
+ *
+ * @param path The file to write.
+ * @param summary The run to describe.
+ *
+ * @return true If the file was written.
+ */
+bool write_stats_json(const std::string& path, const RunSummary& summary);
+
+/**
+ * @brief Print the per-depth, per-rule counters as a table. Prints nothing unless built with NS1D0_STATS.
+ *
+ * @param stats The merged counters.
+ * @param out Where to print the table.
+ *
+ * @return void
+ */
+void print_search_stats(const SearchStats& stats, std::ostream& out);
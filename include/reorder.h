@@ -0,0 +1,162 @@
+/**
+ * @file include/reorder.h
+ *
+ * @brief Writing results in lexicographic order while the workers finish tasks in any order.
+ *
+ * @section Overview
+ *
+ * The depth-first search tries candidates in ascending order, so every task
+ * finds its sequences in lexicographic order, and the sequences of a task all
+ * sort between its prefix followed by its first candidate and the next task's.
+ * That lower bound is the task's order key (task_order_key()). A worker that
+ * splits a task keeps the smaller part, so a task split off always has a larger
+ * key than the task it came from.
+ *
+ * In ordered mode (SearchOptions::ordered) every ResultSlab carries the key of
+ * the task it belongs to. Workers announce every task they split off before they
+ * report the task they split it from as done, and main announces the initial
+ * tasks before any worker starts. The ReorderBuffer on the output thread keeps
+ * the tasks that are not done yet by key: the smallest one is written as its
+ * results arrive, the others are buffered until every task before them is done.
+ * When the buffered results pass a memory limit they are spilled to a temporary
+ * file and read back when their turn comes.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @brief The position of a task in the lexicographic order: its prefix followed by its first candidate.
+ *
+ * @param task The task.
+ *
+ * @return std::vector<int> The key; keys of disjoint tasks sort like the sequences they find.
+ */
+std::vector<int> task_order_key(const SearchTask& task);
+
+/**
+ * @brief Overwrite key with a task's order key, reusing its storage.
+ *
+ * @param task The task.
+ * @param key Receives the key.
+ *
+ * @return void
+ */
+void assign_order_key(const SearchTask& task, std::vector<int>& key);
+
+/**
+ * @brief Announce tasks to the output thread of an ordered run, before any worker starts.
+ *
+ * @param channel The result channel.
+ * @param tasks The tasks the pool is seeded with.
+ *
+ * @return void
+ */
+void announce_tasks(ResultChannel& channel, const std::vector<SearchTask>& tasks);
+
+/**
+ * @struct ReorderStats
+ *
+ * @brief What the reorder buffer did.
+ *
+ * @var peakBytes Most bytes held in memory at once.
+ * @var spilledBytes Bytes written to the spill file.
+ * @var peakPending Most tasks waiting at once, including the one being written.
+ */
+struct ReorderStats {
+    std::size_t peakBytes = 0;
+    std::size_t spilledBytes = 0;
+    std::size_t peakPending = 0;
+};
+
+/**
+ * @class ReorderBuffer
+ *
+ * @brief Puts the slabs of an ordered run back in task order before they reach the writer.
+ *
+ * @details Used by the output thread only. The spill file is created on first use
+ * and unlinked right away, so nothing is left behind if the run is killed.
+ */
+class ReorderBuffer {
+    public:
+        /**
+         * @param writer The writer of the output file.
+         * @param memoryLimit Bytes of results to hold in memory before spilling.
+         * @param spillPath Where to create the spill file.
+         */
+        ReorderBuffer(SeqFileWriter& writer, std::size_t memoryLimit, std::string spillPath);
+        ~ReorderBuffer();
+
+        // Disable copying
+        ReorderBuffer(const ReorderBuffer&) = delete;
+        ReorderBuffer& operator =(const ReorderBuffer&) = delete;
+
+        // Take one slab: write it if its task is the first one pending, buffer it otherwise.
+        void add(const ResultSlab& slab);
+
+        // Write whatever is still pending, in order. Every task is done by now in a complete run.
+        void finish();
+
+        const ReorderStats& stats() const { return stats_; }
+
+        // The first problem with the spill file, or empty. If the file could not be written the
+        // results stayed in memory; if it could not be read back, results are missing and complete() is false.
+        const std::string& error() const { return error_; }
+        bool complete() const { return complete_; }
+
+    private:
+        /**
+         * @brief The results of one task that have not been written yet.
+         *
+         * @var spilled (offset, size) of the parts in the spill file, oldest first.
+         * @var bytes The part still in memory, newer than everything spilled.
+         * @var done Whether the task has finished.
+         */
+        struct Pending {
+            std::vector<std::pair<std::uint64_t, std::size_t>> spilled;
+            std::vector<char> bytes;
+            bool done = false;
+        };
+
+        void advance();
+        void write_out(Pending& task);
+        void spill();
+        bool open_spill_file();
+
+        SeqFileWriter& writer_;
+        std::size_t memoryLimit_;
+        std::string spillPath_;
+        int spillFd_ = -1;
+        bool spillFailed_ = false;
+        std::uint64_t spillEnd_ = 0;
+        std::map<std::vector<int>, Pending> pending_;
+        std::size_t memory_ = 0;   // bytes held in pending_
+        std::vector<char> scratch_;
+        ReorderStats stats_;
+        std::string error_;
+        bool complete_ = true;
+};
+
+/**
+ * @brief Thread function for writing the results of an ordered run.
+ *
+ * @param resultChannel Channel from which to receive the tagged slabs.
+ * @param buffer The reorder buffer in front of the output file's writer.
+ * @param writer The writer; flushed once the channel is closed and drained.
+ * @param sequencesFound Atomic counter for the number of sequences found.
+ *
+ * @return void
+ */
+void ordered_output_thread(ResultChannel& resultChannel,
+                           ReorderBuffer& buffer,
+                           SeqFileWriter& writer,
+                           std::atomic<std::size_t>& sequencesFound);
@@ -0,0 +1,143 @@
+/**
+ * @file include/result_slab.h
+ *
+ * @brief Recycled result slabs, and the channel that carries them from the workers to the output thread.
+ *
+ * @section Overview
+ *
+ * A ResultSlab holds up to kResultBatchSize sequences, already encoded in the
+ * output format. Each worker takes its slabs from its own SlabPool. A full slab
+ * is linked into the ResultChannel as it is, without copying or allocating; the
+ * output thread writes it and hands it back to the pool it came from, where the
+ * worker picks it up again. Once there are enough slabs in circulation to cover
+ * the channel capacity, the result path does no heap allocation at all.
+ *
+ * The hand-back is a lock-free stack per pool: the output thread pushes, the
+ * owning worker takes the whole stack with one exchange, so there is no ABA
+ * problem. Pools belong to the channel, so a slab written after its worker has
+ * exited still has somewhere to go.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "batch_channel.h"
+
+/**
+ * @brief Sequences per ResultSlab a worker collects before publishing it.
+ */
+constexpr std::size_t kResultBatchSize = 256;
+
+class SlabPool;
+
+/**
+ * @struct ResultSlab
+ *
+ * @brief Sequences already encoded in the output format, as sent from a worker to the output thread.
+ *
+ * @var bytes The encoded records, ready to be written; reserved once for a full slab.
+ * @var count Number of sequences in bytes.
+ * @var task In ordered mode, the order key of the task the sequences belong to (see task_order_key()).
+ * @var taskDone In ordered mode, whether this is the task's last slab.
+ * @var owner The pool to give the slab back to once it has been written.
+ * @var next Link used by the channel and by the pool's free lists.
+ */
+struct ResultSlab {
+    std::vector<char> bytes;
+    std::size_t count = 0;
+    std::vector<int> task;
+    bool taskDone = false;
+    SlabPool* owner = nullptr;
+    ResultSlab* next = nullptr;
+};
+
+/**
+ * @class SlabPool
+ *
+ * @brief The slabs of one worker: a private free list plus a stack the output thread returns slabs to.
+ *
+ * @details acquire() is called by the owning worker only; release() by whoever
+ * consumed the slab. A slab is allocated only when both lists are empty.
+ */
+class SlabPool {
+    public:
+        /**
+         * @param slabBytes Bytes to reserve in every new slab.
+         */
+        explicit SlabPool(std::size_t slabBytes);
+
+        // Disable copying
+        SlabPool(const SlabPool&) = delete;
+        SlabPool& operator =(const SlabPool&) = delete;
+
+        // Take an empty slab, reusing a returned one if there is any.
+        ResultSlab* acquire();
+
+        // Give a consumed slab back to its pool; callable from any thread.
+        void release(ResultSlab* slab);
+
+        // Slabs this pool has allocated so far.
+        std::size_t allocated() const { return allocated_.load(std::memory_order_relaxed); }
+
+    private:
+        std::size_t slabBytes_;
+        ResultSlab* free_ = nullptr;                // owner's private list
+        std::atomic<ResultSlab*> returned_{nullptr}; // pushed by consumers, taken whole by the owner
+        std::vector<std::unique_ptr<ResultSlab>> slabs_;
+        std::atomic<std::size_t> allocated_{0};
+};
+
+/**
+ * @class ResultChannel
+ *
+ * @brief The channel from the workers to the output thread, and the owner of every slab pool.
+ *
+ * @details The capacity counts sequences, not slabs, so --queue-capacity means
+ * the same whatever the format. A slab with count 0 still goes through; ordered
+ * mode uses those to announce tasks.
+ */
+class ResultChannel {
+    public:
+        explicit ResultChannel(std::size_t capacity = 0): channel_(capacity) {}
+
+        // Disable copying
+        ResultChannel(const ResultChannel&) = delete;
+        ResultChannel& operator =(const ResultChannel&) = delete;
+
+        // A new pool for one producer, sized for slabs of records of up to recordBytes each.
+        SlabPool& new_pool(std::size_t recordBytes);
+
+        // Publish a slab. If the channel is closed the slab goes straight back to its pool.
+        bool push(ResultSlab* slab) {
+            if (!channel_.push(slab, slab->count)) {
+                slab->owner->release(slab);
+                return false;
+            }
+            return true;
+        }
+
+        // Take every slab published so far, oldest first, appending them to out.
+        // The caller releases each one to its owner once it is done with it.
+        bool pop_all(std::vector<ResultSlab*>& out) {
+            return channel_.pop_all(out, [](const ResultSlab& slab) { return slab.count; });
+        }
+
+        void close() { channel_.close(); }
+
+        // Backpressure counters so far.
+        ChannelStats stats() const { return channel_.stats(); }
+
+        // Slabs allocated by all pools so far.
+        std::size_t slabs_allocated() const;
+
+    private:
+        IntrusiveChannel<ResultSlab> channel_;
+        mutable std::mutex mtx_;
+        std::deque<SlabPool> pools_;
+};
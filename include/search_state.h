@@ -0,0 +1,350 @@
+/**
+ * @file include/search_state.h
+ *
+ * @brief Incremental constraint state used by the NS1D0 depth-first search.
+ *
+ * @details Instead of re-validating the whole prefix at every node with
+ * is_valid_prefix(), the search keeps a SearchState alongside the current
+ * sequence. The state remembers which values are used, which values are
+ * excluded by Rule 5 and which difference pairs are taken by Rule 6, so
+ * checking, pushing and popping a candidate are all O(1) with no allocation.
+ * is_valid_prefix() stays the reference checker for these rules.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ns1d0.h"
+
+/**
+ * @class BitMask
+ *
+ * @brief A fixed-size bit set sized at runtime.
+ *
+ * @details Stores one bit per index in 64-bit words. Unlike std::vector<bool> it
+ * exposes its words so callers can combine masks a word at a time.
+ */
+class BitMask {
+    public:
+        BitMask() = default;
+        explicit BitMask(int bits): bits_(bits), words_((bits + 63) / 64, 0) {}
+
+        bool test(int i) const { return (words_[i >> 6] >> (i & 63)) & 1u; }
+        void set(int i) { words_[i >> 6] |= (std::uint64_t{1} << (i & 63)); }
+        void reset(int i) { words_[i >> 6] &= ~(std::uint64_t{1} << (i & 63)); }
+
+        // True if some bit in (i, size) is clear.
+        bool any_clear_above(int i) const {
+            for (int w = word_count() - 1; w >= 0 && w * 64 + 63 > i; --w) {
+                std::uint64_t clear = ~words_[w];
+                const int hi = bits_ - w * 64;   // bits of this word that are in range
+                const int lo = i + 1 - w * 64;   // first bit of this word above i
+                if (hi < 64) clear &= (std::uint64_t{1} << hi) - 1;
+                if (lo > 0) clear &= ~((std::uint64_t{1} << lo) - 1);
+                if (clear) return true;
+            }
+            return false;
+        }
+
+        int size() const { return bits_; }
+        int word_count() const { return static_cast<int>(words_.size()); }
+        std::uint64_t word(int w) const { return words_[w]; }
+        void set_word(int w, std::uint64_t bits) { words_[w] = bits; }
+
+        // True if this mask and other (of the same size) share a set bit.
+        bool intersects(const BitMask& other) const {
+            for (int w = 0; w < word_count(); ++w) {
+                if (words_[w] & other.words_[w]) return true;
+            }
+            return false;
+        }
+        const std::uint64_t* data() const { return words_.data(); }
+
+        // The mask of the bits in range, in the top word (all ones for the other words).
+        std::uint64_t top_mask() const {
+            const int used = bits_ - (word_count() - 1) * 64;
+            return used == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << used) - 1;
+        }
+
+        // Write src rotated left by s (0 <= s < size) within size bits to out, which has src's size.
+        static void rotate_left(const BitMask& src, int s, BitMask& out) {
+            const int words = src.word_count();
+            const int t = src.bits_ - s;            // the wrapped part is src >> t
+            for (int w = 0; w < words; ++w) {
+                out.words_[w] = shifted_word(src, w, -s) | shifted_word(src, w, t);
+            }
+            out.words_[words - 1] &= src.top_mask();
+        }
+
+    private:
+        // Word w of src shifted right by shift bits (left for negative shift).
+        static std::uint64_t shifted_word(const BitMask& src, int w, int shift) {
+            const int words = src.word_count();
+            const int q = shift >= 0 ? shift / 64 : -((-shift + 63) / 64);
+            const int r = shift - q * 64;           // 0 <= r < 64
+            const int lo = w + q;
+            std::uint64_t out = 0;
+            if (lo >= 0 && lo < words) out |= src.words_[lo] >> r;
+            if (r != 0 && lo + 1 >= 0 && lo + 1 < words) out |= src.words_[lo + 1] << (64 - r);
+            return out;
+        }
+
+        int bits_ = 0;
+        std::vector<std::uint64_t> words_;
+};
+
+/**
+ * @class SearchState
+ *
+ * @brief The current prefix plus the bookkeeping needed to extend it in O(1).
+ *
+ * @details Rules are checked only for the element being appended, which is
+ * enough because every element already on the stack was checked when it was
+ * pushed. A candidate accepted by can_push() always yields a prefix that
+ * is_valid_prefix() accepts as well.
+ *
+ * candidates() builds the whole set of valid next values at once, a word at a
+ * time: the unused values that are not excluded by Rules 3-5, intersected with
+ * the free differences rotated by the last element (Rule 6).
+ */
+class SearchState {
+    public:
+        /**
+         * @class Candidates
+         *
+         * @brief The valid next values of a node, iterated in increasing order.
+         *
+         * @details Points into the state's scratch mask for the node's depth, so it stays
+         * valid while deeper nodes build their own sets.
+         */
+        class Candidates {
+            public:
+                Candidates(const std::uint64_t* words, int count)
+                    : words_(words), count_(count), current_(count > 0 ? words[0] : 0) {}
+
+                // Take the next value; false once there are none left.
+                bool next(int& v) {
+                    while (current_ == 0) {
+                        if (++word_ >= count_) return false;
+                        current_ = words_[word_];
+                    }
+                    v = word_ * 64 + __builtin_ctzll(current_);
+                    current_ &= current_ - 1;
+                    return true;
+                }
+
+            private:
+                const std::uint64_t* words_;
+                int count_;
+                int word_ = 0;
+                std::uint64_t current_;
+        };
+
+        explicit SearchState(const NS1D0Config& cfg)
+            : cfg_(cfg),
+              used_(cfg.n),
+              excluded_(cfg.n),
+              usedPair_(cfg.n / 2 + 1),
+              freeDiffs_(cfg.n),
+              rotated_(cfg.n),
+              available_(cfg.n),
+              reach_(cfg.n),
+              scratch_(cfg.targetLength + 1, BitMask(cfg.n)) {
+            seq_.reserve(cfg.targetLength);
+            for (int d = 1; d < cfg.n; ++d) {
+                freeDiffs_.set(d);
+            }
+        }
+
+        // Check whether appending v keeps the prefix valid (Rules 1-6).
+        bool can_push(int v) const { return check(v) == PruneReason::None; }
+
+        // Like can_push(), but say which rule rejects v.
+        PruneReason check(int v) const {
+            const int size = static_cast<int>(seq_.size());
+            if (size >= cfg_.targetLength) return PruneReason::Length;       // Rule 1
+            if (v < 0 || v >= cfg_.n) return PruneReason::Range;             // range
+            if (size == 0) return v == 0 ? PruneReason::None : PruneReason::Start; // Rule 2
+            if (used_.test(v)) return PruneReason::Unique;                   // unique
+            if ((v == 1) != (size + 1 == cfg_.targetLength)) {
+                return PruneReason::OneAtEnd;                                // Rule 3
+            }
+            if (v == cfg_.forbidden) return PruneReason::Forbidden;          // Rule 4
+            if (excluded_.test(v)) return PruneReason::PairExclusion;        // Rule 5
+            if (usedPair_.test(pair_of(v - seq_.back()))) {
+                return PruneReason::DifferencePair;                          // Rule 6
+            }
+            return PruneReason::None;
+        }
+
+        // The valid next values from first on (Rules 1-6).
+        Candidates candidates(int first) const {
+            const int size = static_cast<int>(seq_.size());
+            BitMask& out = scratch_[size];
+            const int words = out.word_count();
+
+            if (size >= cfg_.targetLength || size == 0) {
+                // Complete, or the root, whose only child is 0 (Rule 2)
+                for (int w = 0; w < words; ++w) out.set_word(w, 0);
+                if (size == 0 && first <= 0) out.set(0);
+                return Candidates(out.data(), words);
+            }
+
+            BitMask::rotate_left(freeDiffs_, seq_.back(), rotated_);
+            for (int w = 0; w < words; ++w) {
+                std::uint64_t bits = rotated_.word(w) & ~used_.word(w) & ~excluded_.word(w);
+                // Candidates below first belong to somebody else
+                const int lo = first - w * 64;
+                if (lo >= 64) bits = 0;
+                else if (lo > 0) bits &= ~((std::uint64_t{1} << lo) - 1);
+                out.set_word(w, bits);
+            }
+            out.reset(cfg_.forbidden);                          // Rule 4
+            if (size + 1 == cfg_.targetLength) {                // Rule 3: only 1 goes last
+                const bool one = out.test(1);
+                for (int w = 0; w < words; ++w) out.set_word(w, 0);
+                if (one) out.set(1);
+            } else {
+                out.reset(1);
+            }
+            return Candidates(out.data(), words);
+        }
+
+        // Append v. The caller must have checked can_push(v).
+        void push(int v) {
+            if (!seq_.empty()) {
+                const int p = pair_of(v - seq_.back());
+                usedPair_.set(p);
+                freeDiffs_.reset(p);
+                freeDiffs_.reset(cfg_.n - p);
+            }
+            used_.set(v);
+            if (v >= 2) {
+                excluded_.set(partner_of(v));
+            }
+            seq_.push_back(v);
+        }
+
+        // Remove the last element, undoing everything push() recorded.
+        void pop() {
+            const int v = seq_.back();
+            seq_.pop_back();
+            if (v >= 2) {
+                excluded_.reset(partner_of(v));
+            }
+            used_.reset(v);
+            if (!seq_.empty()) {
+                const int p = pair_of(v - seq_.back());
+                usedPair_.reset(p);
+                freeDiffs_.set(p);
+                freeDiffs_.set(cfg_.n - p);
+            }
+        }
+
+        // Symmetry breaking: can this prefix still grow into the canonical member of its orbit?
+        //
+        // The map a_i -> (1 - a_{k-1-i}) mod n preserves Rules 1-6 and reverses the sequence
+        // of differences. Every valid sequence uses each difference pair exactly once, so the
+        // pair of the last difference is whichever pair is still unused at the end. We call a
+        // sequence canonical when its first difference pair is smaller than its last one, which
+        // holds for exactly one member of each orbit and needs some unused pair above the first.
+        // Only meaningful for incomplete prefixes: a complete one whose parent passed is canonical.
+        bool canonical_possible() const {
+            if (seq_.size() < 2) return true;
+            return usedPair_.any_clear_above(pair_of(seq_[1] - seq_[0]));
+        }
+
+        // Lookahead: can this (incomplete, non-empty) prefix still be completed?
+        //
+        // Every valid sequence ends ..., x, 1 and uses every difference pair exactly once, so
+        //  - FinalStep: some value x that is still free must have pair(1 - x) free, and when x is
+        //    the next element it must also be reachable from the last one; with no element left
+        //    before the 1, pair(1 - last) itself must be free;
+        //  - PairCoverage: every free pair d must be the difference of two values that can still
+        //    appear in the rest of the path (the free values, 1 and the last element).
+        // Counting free values or pairs against the remaining positions never prunes: both
+        // counts always match exactly.
+        PruneReason lookahead() const {
+            const int remaining = cfg_.targetLength - static_cast<int>(seq_.size());
+            const int last = seq_.back();
+            if (remaining == 1) {
+                return freeDiffs_.test(partner_of(last)) ? PruneReason::None : PruneReason::FinalStep;
+            }
+
+            // Values that can still be used before the final 1
+            const int words = available_.word_count();
+            for (int w = 0; w < words; ++w) {
+                available_.set_word(w, ~used_.word(w) & ~excluded_.word(w));
+            }
+            available_.set_word(words - 1, available_.word(words - 1) & available_.top_mask());
+            available_.reset(cfg_.forbidden);
+            available_.reset(1);
+
+            // Values next to the final 1: x with x - 1 a free difference
+            BitMask::rotate_left(freeDiffs_, 1, rotated_);
+            if (remaining == 2) {
+                BitMask::rotate_left(freeDiffs_, last, reach_);
+                for (int w = 0; w < words; ++w) {
+                    rotated_.set_word(w, rotated_.word(w) & reach_.word(w));
+                }
+            }
+            if (!rotated_.intersects(available_)) {
+                return PruneReason::FinalStep;
+            }
+
+            reach_ = available_;
+            reach_.set(1);
+            reach_.set(last);
+            for (int p = 1; p <= cfg_.n / 2; ++p) {
+                if (usedPair_.test(p)) continue;
+                BitMask::rotate_left(reach_, p, rotated_);
+                if (!rotated_.intersects(reach_)) {
+                    return PruneReason::PairCoverage;
+                }
+            }
+            return PruneReason::None;
+        }
+
+        // Write the symmetric partner (1 - a_{k-1-i}) mod n of the current sequence to out.
+        void mirror(std::vector<int>& out) const {
+            out.resize(seq_.size());
+            for (std::size_t i = 0; i < seq_.size(); ++i) {
+                out[i] = partner_of(seq_[seq_.size() - 1 - i]);
+            }
+        }
+
+        bool contains(int v) const { return used_.test(v); }
+        bool complete() const { return static_cast<int>(seq_.size()) == cfg_.targetLength; }
+        int size() const { return static_cast<int>(seq_.size()); }
+        const std::vector<int>& sequence() const { return seq_; }
+        const NS1D0Config& config() const { return cfg_; }
+        int n() const { return cfg_.n; }
+        int length() const { return cfg_.targetLength; }
+
+    private:
+        int mod_n(int a) const {
+            int r = a % cfg_.n;
+            return r < 0 ? r + cfg_.n : r;
+        }
+
+        // The Rule 5 partner (1 - x) mod n.
+        int partner_of(int v) const { return mod_n(1 - v); }
+
+        // The Rule 6 representative min(d, -d mod n) of a difference.
+        int pair_of(int diff) const {
+            const int d = mod_n(diff);
+            return d <= cfg_.n - d ? d : cfg_.n - d;
+        }
+
+        const NS1D0Config& cfg_;
+        std::vector<int> seq_;
+        BitMask used_;       // values already in the sequence
+        BitMask excluded_;   // values whose (1 - x) partner is in the sequence
+        BitMask usedPair_;   // difference pairs already taken
+        BitMask freeDiffs_;  // differences d in [1, n) whose pair is still free
+        mutable BitMask rotated_;               // scratch: free differences rotated by the last element
+        mutable BitMask available_;             // scratch for lookahead()
+        mutable BitMask reach_;                 // scratch for lookahead()
+        mutable std::vector<BitMask> scratch_;  // candidate sets, one per depth
+};
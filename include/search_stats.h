@@ -0,0 +1,132 @@
+/**
+ * @file include/search_stats.h
+ *
+ * @brief Optional per-rule, per-depth search counters and the live progress counters.
+ *
+ * @section Overview
+ *
+ * SearchStats records, for every depth of the search tree, how many nodes were
+ * visited and how many candidates each rule pruned. It is compiled in only when
+ * NS1D0_STATS is defined (make STATS=1); otherwise every member function is an
+ * empty inline function and the counters cost nothing. Each worker keeps its own
+ * SearchStats, and main merges them once the workers have finished.
+ *
+ * LiveProgress is always on. Workers publish their counters into it every few
+ * thousand nodes so the progress reporter can read them while the search runs.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef NS1D0_STATS
+constexpr bool kSearchStatsEnabled = true;
+#else
+constexpr bool kSearchStatsEnabled = false;
+#endif
+
+/**
+ * @brief Why a candidate was rejected. Mirrors the rule functions behind is_valid_prefix().
+ */
+enum class PruneReason : std::uint8_t {
+    None = 0,           // accepted
+    Length,             // Rule 1: the sequence is already complete
+    Range,              // not in [0, n)
+    Start,              // Rule 2: the first element must be 0
+    Unique,             // already in the sequence
+    OneAtEnd,           // Rule 3: 1 only in the last position
+    Forbidden,          // Rule 4: ceil(n/2)
+    PairExclusion,      // Rule 5: (1 - x) mod n is in the sequence
+    DifferencePair,     // Rule 6: the difference pair is taken
+    Symmetry,           // only the mirror of this subtree is canonical
+    FinalStep,          // lookahead: no value is left that can step into the final 1
+    PairCoverage,       // lookahead: a free difference pair can no longer be used
+    Count
+};
+
+constexpr std::size_t kPruneReasonCount = static_cast<std::size_t>(PruneReason::Count);
+
+/**
+ * @brief Short name of a prune reason, as used in reports and the JSON dump.
+ */
+const char* prune_reason_name(PruneReason reason);
+
+/**
+ * @class SearchStats
+ *
+ * @brief Nodes visited and candidates pruned per rule, per depth.
+ *
+ * @details The depth of a candidate is the position it would fill. Visited nodes
+ * are the valid children the search descends into; the candidates the rules rule
+ * out are attributed to the first rule that rejects them, in a separate pass.
+ * Symmetry and lookahead prunes are counted at the depth of the pruned node.
+ */
+class SearchStats {
+    public:
+        static constexpr bool enabled = kSearchStatsEnabled;
+
+        // Make room for depths [0, depths). A no-op when disabled.
+        void resize(int depths) {
+            if constexpr (enabled) {
+                visited_.resize(depths, 0);
+                pruned_.resize(depths, PrunedCounts{});
+            }
+        }
+
+        void visit(int depth) {
+            if constexpr (enabled) ++visited_[depth];
+        }
+
+        void prune(PruneReason reason, int depth) {
+            if constexpr (enabled) ++pruned_[depth][static_cast<std::size_t>(reason)];
+        }
+
+        // Add another worker's counters to these.
+        void merge(const SearchStats& other) {
+            if constexpr (enabled) {
+                if (visited_.size() < other.visited_.size()) resize(static_cast<int>(other.visited_.size()));
+                for (std::size_t d = 0; d < other.visited_.size(); ++d) {
+                    visited_[d] += other.visited_[d];
+                    for (std::size_t r = 0; r < kPruneReasonCount; ++r) {
+                        pruned_[d][r] += other.pruned_[d][r];
+                    }
+                }
+            } else {
+                (void)other;
+            }
+        }
+
+        int depths() const { return static_cast<int>(visited_.size()); }
+        std::size_t visited(int depth) const { return visited_[depth]; }
+        std::size_t pruned(int depth, PruneReason reason) const {
+            return pruned_[depth][static_cast<std::size_t>(reason)];
+        }
+
+    private:
+        using PrunedCounts = std::array<std::size_t, kPruneReasonCount>;
+
+        std::vector<std::size_t> visited_;
+        std::vector<PrunedCounts> pruned_;
+};
+
+/**
+ * @struct LiveProgress
+ *
+ * @brief One worker's counters as seen by the progress reporter while the search runs.
+ *
+ * @var nodes Nodes expanded so far.
+ * @var sequences Sequences found so far.
+ * @var explored Fraction of the whole search tree this worker has finished, weighting
+ * every candidate of a node equally (see dfs_search).
+ *
+ * @details Written by its worker only, read by the reporter; padded so workers do not share cache lines.
+ */
+struct alignas(64) LiveProgress {
+    std::atomic<std::size_t> nodes{0};
+    std::atomic<std::size_t> sequences{0};
+    std::atomic<double> explored{0.0};
+};
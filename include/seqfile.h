@@ -0,0 +1,254 @@
+/**
+ * @file include/seqfile.h
+ *
+ * @brief Writing and reading NS1D0 result files in text or compact binary form.
+ *
+ * @section Overview
+ *
+ * The text format is the original one: one sequence per line, elements separated
+ * by ", ". The binary formats start with a fixed 16-byte header followed by one
+ * fixed-size record per sequence:
+ *
+ *   offset  size  field
+ *   0       4     magic "NS1D"
+ *   4       1     version (1)
+ *   5       1     format (1 = one byte per element, 2 = packed)
+ *   6       1     bits per element (8 for bytes, ceil(log2 n) for packed)
+ *   7       1     reserved (0)
+ *   8       4     n (little-endian)
+ *   12      4     sequence length (little-endian)
+ *
+ * A packed record stores the elements least significant bit first and is padded
+ * to a whole byte, so every record starts on a byte boundary and can be found
+ * without scanning. The number of sequences follows from the file size.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The on-disk formats of a result file.
+ */
+enum class SeqFormat : std::uint8_t {
+    Text = 0,
+    Bytes = 1,
+    Packed = 2
+};
+
+/**
+ * @brief Size in bytes of the binary file header.
+ */
+constexpr std::size_t kSeqFileHeaderSize = 16;
+
+/**
+ * @brief Number of bits a packed element needs for a given n, i.e. ceil(log2 n).
+ */
+int seqfile_bits_for(int n);
+
+/**
+ * @brief Parse a format name ("text", "bytes" or "packed").
+ *
+ * @param name The name to parse.
+ * @param out Receives the format.
+ *
+ * @return true If the name is known.
+ */
+bool parse_seq_format(const std::string& name, SeqFormat& out);
+
+/**
+ * @brief Name of a format, as accepted by parse_seq_format().
+ *
+ * @param format The format.
+ *
+ * @return const char* "text", "bytes" or "packed".
+ */
+const char* seq_format_name(SeqFormat format);
+
+/**
+ * @brief Parse one text line such as "0, 5, 2, 1" into integers.
+ *
+ * @param begin Start of the line (without the newline).
+ * @param end One past the end of the line.
+ * @param out Receives the elements; cleared first.
+ *
+ * @return true If the line is a non-empty list of non-negative integers that fit in an int.
+ */
+bool parse_text_sequence(const char* begin, const char* end, std::vector<int>& out);
+
+/**
+ * @class SeqEncoder
+ *
+ * @brief Encodes sequences into the bytes of one SeqFormat layout.
+ *
+ * @details Text is formatted with std::to_chars, so no stream, locale or
+ * formatting state is involved. An encoder holds no buffers of its own, so each
+ * worker can encode its results into its own memory and the writer thread only
+ * has to copy bytes.
+ */
+class SeqEncoder {
+    public:
+        SeqEncoder(SeqFormat format, int n, int length);
+
+        // Append the encoding of one sequence of exactly length() elements to out.
+        void encode(const int* seq, std::vector<char>& out) const;
+
+        SeqFormat format() const { return format_; }
+        int n() const { return n_; }
+        int length() const { return length_; }
+        int bits() const { return bits_; }
+
+        // An upper bound on the bytes encode() appends for one sequence.
+        std::size_t max_bytes() const { return maxBytes_; }
+
+        // Bytes taken by the first count records of encoded data, or size if it holds fewer.
+        std::size_t prefix_bytes(const char* data, std::size_t size, std::size_t count) const;
+
+    private:
+        SeqFormat format_;
+        int n_;
+        int length_;
+        int bits_;
+        std::size_t maxBytes_;
+};
+
+/**
+ * @class SeqFileWriter
+ *
+ * @brief Streams sequences to an output stream in one of the SeqFormat layouts.
+ *
+ * @details For the binary formats the header is written by the constructor, unless
+ * the writer is appending to an existing file. Records are collected in a buffer of
+ * kBufferBytes and handed to the stream in one write() when it fills up, which a
+ * file stream passes straight to the kernel. Call flush() before looking at the
+ * stream; the destructor flushes too. The stream is checked after every write:
+ * once one fails (a full disk, say) failed() stays true and the rest is dropped.
+ */
+class SeqFileWriter {
+    public:
+        // Size of the write buffer; the stream sees writes of about this size.
+        static constexpr std::size_t kBufferBytes = std::size_t{4} << 20;
+
+        SeqFileWriter(std::ostream& out, SeqFormat format, int n, int length, bool writeHeader = true);
+        ~SeqFileWriter();
+
+        // Disable copying
+        SeqFileWriter(const SeqFileWriter&) = delete;
+        SeqFileWriter& operator =(const SeqFileWriter&) = delete;
+
+        // Write one sequence of exactly length() elements.
+        void write(const int* seq);
+        void write(const std::vector<int>& seq) { write(seq.data()); }
+
+        // Write records already encoded by an encoder with the same format, n and length.
+        void write_encoded(const char* data, std::size_t size);
+
+        // Hand everything buffered to the stream and flush the stream.
+        void flush();
+
+        // Whether a write to the stream has failed; everything after it was dropped.
+        bool failed() const { return failed_; }
+
+        // The stream position, i.e. the bytes written so far when the file was empty;
+        // only meaningful right after flush().
+        std::streamoff position() const { return out_.tellp(); }
+
+        const SeqEncoder& encoder() const { return encoder_; }
+        SeqFormat format() const { return encoder_.format(); }
+        int length() const { return encoder_.length(); }
+
+    private:
+        // Pass the buffer to the stream.
+        void drain();
+
+        std::ostream& out_;
+        SeqEncoder encoder_;
+        std::vector<char> buffer_;
+        bool failed_ = false;
+};
+
+/**
+ * @class MappedFile
+ *
+ * @brief A whole file mapped read-only into memory.
+ *
+ * @details The kernel is told the file will be read sequentially, so it reads
+ * ahead aggressively. An empty file maps to no data and size 0.
+ */
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        // Disable copying
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator =(const MappedFile&) = delete;
+
+        // Map a file. On failure, error says why.
+        bool open(const std::string& path, std::string& error);
+        void close();
+
+        const char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+};
+
+/**
+ * @class SeqFileReader
+ *
+ * @brief Memory-maps a binary result file and gives indexed access to its sequences.
+ *
+ * @details Nothing is copied when the file is opened. For the byte format, raw()
+ * points straight at a record's elements in the mapping; read() decodes a record
+ * of either binary format into ints.
+ */
+class SeqFileReader {
+    public:
+        SeqFileReader() = default;
+        ~SeqFileReader();
+
+        // Disable copying
+        SeqFileReader(const SeqFileReader&) = delete;
+        SeqFileReader& operator =(const SeqFileReader&) = delete;
+
+        // Map a file and check its header. On failure, error says why.
+        bool open(const std::string& path, std::string& error);
+        void close();
+
+        // Check the header of a file already mapped; the mapping must outlive the reader.
+        bool open(const MappedFile& file, const std::string& path, std::string& error);
+
+        int n() const { return n_; }
+        int length() const { return length_; }
+        SeqFormat format() const { return format_; }
+        std::size_t count() const { return count_; }
+
+        // The encoded bytes of sequence i. For SeqFormat::Bytes these are the elements.
+        const std::uint8_t* raw(std::size_t i) const {
+            return data_ + kSeqFileHeaderSize + i * recordBytes_;
+        }
+
+        // Decode sequence i into out, which must have room for length() ints; false if an element is >= n.
+        bool read(std::size_t i, int* out) const;
+
+        // Bytes of one record.
+        std::size_t record_bytes() const { return recordBytes_; }
+
+    private:
+        MappedFile file_;                    // unused when opened on someone else's mapping
+        const std::uint8_t* data_ = nullptr;
+        std::size_t size_ = 0;
+        int n_ = 0;
+        int length_ = 0;
+        int bits_ = 0;
+        SeqFormat format_ = SeqFormat::Bytes;
+        std::size_t recordBytes_ = 0;
+        std::size_t count_ = 0;
+};
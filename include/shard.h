@@ -0,0 +1,171 @@
+/**
+ * @file include/shard.h
+ *
+ * @brief Splitting one search over several processes, and the manifests that describe each part.
+ *
+ * @section Overview
+ *
+ * A sharded run (--shard i/k) enumerates every valid prefix of a fixed length,
+ * chosen from n and k alone so that there are at least kPrefixesPerShard
+ * prefixes per shard, and keeps those whose hash maps to shard i. The hash only
+ * depends on the prefix, so every process of a run agrees on the split without
+ * talking to the others, on any machine.
+ *
+ * Each shard writes its own output file and a manifest listing the prefixes it
+ * searched and what it found. The shardmerge tool checks that the manifests of a
+ * run cover every prefix exactly once and concatenates or counts the results.
+ *
+ * Manifest files are plain text:
+ *
+ *   NS1D0-SHARD 1
+ *   n <n>
+ *   shard <i> <k>
+ *   depth <prefix length>
+ *   symmetry <0|1>
+ *   count_only <0|1>
+ *   format <text|bytes|packed>
+ *   output <file>                 ("-" in count-only mode)
+ *   sequences <count>
+ *   nodes <count>
+ *   prefixes <m>
+ *   <prefix>...                   (m lines)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns1d0.h"
+
+/**
+ * @brief The minimum number of prefixes per shard; more prefixes balance the shards better.
+ */
+constexpr std::size_t kPrefixesPerShard = 64;
+
+/**
+ * @struct ShardSpec
+ *
+ * @brief Which part of a sharded run this process searches.
+ *
+ * @var index This shard, in [0, count).
+ * @var count Number of shards; 0 when the run is not sharded.
+ */
+struct ShardSpec {
+    int index = 0;
+    int count = 0;
+};
+
+/**
+ * @struct ShardManifest
+ *
+ * @brief The contents of a shard manifest.
+ *
+ * @var n The modulus searched.
+ * @var shard Which shard of how many.
+ * @var depth Length of the prefixes the run was split at.
+ * @var symmetry Whether only canonical sequences were searched (their mirrors are in the output).
+ * @var countOnly Whether the shard only counted sequences.
+ * @var format The format of the output file.
+ * @var output The output file; empty in count-only mode.
+ * @var sequences Sequences the shard found.
+ * @var nodes Nodes the shard expanded.
+ * @var prefixes The prefixes the shard searched.
+ */
+struct ShardManifest {
+    int n = 0;
+    ShardSpec shard;
+    int depth = 0;
+    bool symmetry = true;
+    bool countOnly = false;
+    SeqFormat format = SeqFormat::Text;
+    std::string output;
+    std::size_t sequences = 0;
+    std::size_t nodes = 0;
+    std::vector<std::vector<int>> prefixes;
+};
+
+/**
+ * @brief Parse a shard spec of the form "i/k" with 0 <= i < k.
+ *
+ * @param text The text to parse.
+ * @param out Receives the spec.
+ *
+ * @return true If the text is a valid spec.
+ */
+bool parse_shard_spec(const std::string& text, ShardSpec& out);
+
+/**
+ * @brief Every valid prefix of the given length, in lexicographic order.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param length The prefix length, at most cfg.targetLength.
+ *
+ * @return std::vector<std::vector<int>> The prefixes.
+ */
+std::vector<std::vector<int>> valid_prefixes(const NS1D0Config& cfg, int length);
+
+/**
+ * @brief The prefix length a run with shardCount shards is split at.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param shardCount Number of shards.
+ *
+ * @return int The shortest length from 2 up with at least kPrefixesPerShard prefixes per shard,
+ * but no longer than the sequences allow.
+ */
+int shard_depth(const NS1D0Config& cfg, int shardCount);
+
+/**
+ * @brief The shard a prefix belongs to: a 64-bit FNV-1a hash of its elements modulo the shard count.
+ *
+ * @param prefix The prefix.
+ * @param shardCount Number of shards.
+ *
+ * @return int The shard index.
+ */
+int shard_of(const std::vector<int>& prefix, int shardCount);
+
+/**
+ * @brief The prefixes a shard searches.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param spec The shard.
+ * @param depth Receives the prefix length, see shard_depth().
+ *
+ * @return std::vector<std::vector<int>> The prefixes, in lexicographic order.
+ */
+std::vector<std::vector<int>> shard_prefixes(const NS1D0Config& cfg, const ShardSpec& spec, int& depth);
+
+/**
+ * @brief The search task that covers exactly the subtree below a prefix.
+ *
+ * @param prefix A valid prefix of length 2 or more.
+ *
+ * @return SearchTask The task: the prefix without its last element, with that element as the only candidate.
+ */
+SearchTask prefix_task(const std::vector<int>& prefix);
+
+/**
+ * @brief Write a shard manifest.
+ *
+ * @param path The manifest file.
+ * @param m The manifest to write.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was written.
+ */
+bool save_shard_manifest(const std::string& path, const ShardManifest& m, std::string& error);
+
+/**
+ * @brief Read a shard manifest.
+ *
+ * @param path The manifest file.
+ * @param m Receives the manifest.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was read and is well formed.
+ */
+bool load_shard_manifest(const std::string& path, ShardManifest& m, std::string& error);
@@ -0,0 +1,163 @@
+/**
+ * @file include/work_stealing.h
+ *
+ * @brief A work-stealing task pool for the NS1D0 search.
+ *
+ * @section Overview
+ *
+ * Each worker owns a deque of prefix tasks. A worker pops its own newest task
+ * from the back and, when it runs dry, steals the oldest task from the front
+ * of another worker's deque. Busy workers split their search tree on demand
+ * (see dfs_search) whenever somebody is idle, so the oldest tasks are always
+ * the shallowest, and therefore largest, unexplored branches.
+ *
+ * The pool can also stop the world for a checkpoint: pause() waits until every
+ * worker has either parked (handing over its unexplored frontier as tasks) or
+ * is idle, and then returns the whole remaining search as a list of tasks.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @struct SearchTask
+ *
+ * @brief A range of children of one fixed prefix.
+ *
+ * @var prefix The elements already fixed, starting with 0.
+ * @var first The first candidate to try for the next position.
+ * @var last One past the last candidate to try for the next position.
+ * @var job In a sweep over several n, the search the task belongs to (see sweep_worker()); 0 otherwise.
+ */
+struct SearchTask {
+    std::vector<int> prefix;
+    int first;
+    int last;
+    int job = 0;
+};
+
+/**
+ * @struct WorkerStats
+ *
+ * @brief Per-worker scheduling counters.
+ *
+ * @var busySeconds Time spent running tasks.
+ * @var idleSeconds Time spent looking or waiting for a task.
+ * @var tasksRun Number of tasks this worker ran.
+ * @var tasksStolen How many of those were stolen from another worker.
+ */
+struct WorkerStats {
+    double busySeconds = 0.0;
+    double idleSeconds = 0.0;
+    std::size_t tasksRun = 0;
+    std::size_t tasksStolen = 0;
+};
+
+/**
+ * @class WorkStealingPool
+ *
+ * @brief Per-worker task deques with stealing and global termination detection.
+ *
+ * @details The pool only hands out tasks; the workers run them. A task counts as
+ * pending from the moment it is pushed until the worker that took it calls
+ * task_done(), so next() can tell "nothing queued right now" apart from
+ * "the whole search is finished".
+ */
+class WorkStealingPool {
+    public:
+        explicit WorkStealingPool(int workerCount);
+
+        // Disable copying
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator =(const WorkStealingPool&) = delete;
+
+        // Push a task onto the back of a worker's deque.
+        void push(int worker, SearchTask task);
+
+        // Take the next task for a worker: its own newest task first, otherwise
+        // the oldest task of another worker. Blocks while other workers may still
+        // produce tasks. Returns false once every task has finished or the pool is cancelled.
+        bool next(int worker, SearchTask& out);
+
+        // Mark the task most recently returned by next() as finished.
+        void task_done();
+
+        // True when some worker is waiting for work, i.e. busy workers should split.
+        bool hungry() const { return idle_.load(std::memory_order_relaxed) > 0; }
+
+        // Number of tasks queued on a worker's own deque.
+        std::size_t queued(int worker) const {
+            return queues_[worker].size.load(std::memory_order_relaxed);
+        }
+
+        int worker_count() const { return workerCount_; }
+
+        // Scheduling counters; only valid once the workers have finished.
+        const WorkerStats& stats(int worker) const { return stats_[worker].stats; }
+
+        // Account time spent running a task to a worker.
+        void add_busy_time(int worker, double seconds) { stats_[worker].stats.busySeconds += seconds; }
+
+        // True while a checkpoint wants the workers to park; cheap enough to poll per node.
+        bool pause_requested() const { return pause_.load(std::memory_order_relaxed); }
+
+        // Called by a worker that saw pause_requested(): hand over the work it has not
+        // explored yet and block until resume().
+        void park(std::vector<SearchTask> frontier);
+
+        // Stop the world. Returns false if the search finished instead; otherwise
+        // fills frontier with every unexplored task and leaves the workers parked.
+        bool pause(std::vector<SearchTask>& frontier);
+
+        // Let parked workers continue after pause().
+        void resume();
+
+        // Stop handing out tasks: next() returns false from now on, also to idle workers.
+        // Running tasks are abandoned by workers that poll cancelled().
+        void cancel();
+
+        // True once cancel() was called; cheap enough to poll per node.
+        bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+    private:
+        struct alignas(64) WorkerQueue {
+            std::mutex mtx;
+            std::deque<SearchTask> tasks;
+            std::atomic<std::size_t> size{0};
+        };
+
+        struct alignas(64) PaddedStats {
+            WorkerStats stats;
+        };
+
+        bool try_pop_back(int worker, SearchTask& out);
+        bool try_steal(int thief, SearchTask& out);
+
+        int workerCount_;
+        std::unique_ptr<WorkerQueue[]> queues_;
+        std::unique_ptr<PaddedStats[]> stats_;
+
+        std::atomic<std::size_t> queuedTotal_{0};   // tasks sitting in deques
+        std::atomic<std::size_t> pending_{0};       // tasks queued or running
+        std::atomic<int> idle_{0};                  // workers waiting in next()
+        std::atomic<bool> cancelled_{false};        // set by cancel()
+
+        std::mutex idleMtx_;
+        std::condition_variable idleCv_;
+
+        // Checkpoint pause state, guarded by idleMtx_
+        std::atomic<bool> pause_{false};
+        int parked_ = 0;                            // workers parked in this pause
+        int exited_ = 0;                            // workers that left next() for good
+        unsigned pauseEpoch_ = 0;                   // bumped by every resume()
+        std::vector<SearchTask> parkedFrontier_;    // work handed over by parked workers
+        std::condition_variable pauseCv_;           // wakes the thread waiting in pause()
+        std::condition_variable resumeCv_;          // wakes parked workers
+};
@@ -0,0 +1,38 @@
+/**
+ * @file src/alloc_counter.cpp
+ *
+ * @brief Replacement global operator new and delete that count allocations.
+ */
+
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Count every heap allocation made by the process
+static std::atomic<std::size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC cannot see that the replaced operator new above is what allocated these
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+/**
+ * @brief Heap allocations made through operator new so far, by every thread.
+ *
+ * @return std::size_t The count.
+ */
+std::size_t heap_allocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,258 @@
+/**
+ * @file src/checkpoint.cpp
+ *
+ * @brief Implementation of checkpoint files and the background checkpointer.
+ */
+
+#include "checkpoint.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+static const char* const kCheckpointMagic = "NS1D0-CHECKPOINT";
+static constexpr int kCheckpointVersion = 1;
+
+/**
+ * @brief Write a checkpoint file atomically (via a temporary file and rename).
+ *
+ * @param path The checkpoint file.
+ * @param cp The checkpoint to write.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was written.
+ */
+bool save_checkpoint(const std::string& path, const Checkpoint& cp, std::string& error) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out.is_open()) {
+            error = "could not create " + tmp;
+            return false;
+        }
+
+        out << kCheckpointMagic << ' ' << kCheckpointVersion << '\n';
+        out << "n " << cp.n << '\n';
+        out << "symmetry " << (cp.symmetry ? 1 : 0) << '\n';
+        out << "count_only " << (cp.countOnly ? 1 : 0) << '\n';
+        out << "format " << seq_format_name(cp.format) << '\n';
+        out << "output_offset " << cp.outputOffset << '\n';
+        out << "sequences " << cp.sequences << '\n';
+        out << "nodes " << cp.nodes << '\n';
+        out << "by_second " << cp.bySecond.size();
+        for (std::size_t c : cp.bySecond) {
+            out << ' ' << c;
+        }
+        out << '\n';
+        out << "tasks " << cp.tasks.size() << '\n';
+        for (const SearchTask& task : cp.tasks) {
+            out << task.first << ' ' << task.last << ' ' << task.prefix.size();
+            for (int v : task.prefix) {
+                out << ' ' << v;
+            }
+            out << '\n';
+        }
+
+        out.flush();
+        if (!out) {
+            error = "could not write " + tmp;
+            return false;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "could not replace " + path;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read a checkpoint file.
+ *
+ * @param path The checkpoint file.
+ * @param cp Receives the checkpoint.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was read and is well formed.
+ */
+bool load_checkpoint(const std::string& path, Checkpoint& cp, std::string& error) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    // Read "<key> <value>" and check the key
+    auto expect = [&](const char* key) {
+        std::string word;
+        in >> word;
+        return static_cast<bool>(in) && word == key;
+    };
+
+    std::string magic;
+    int version = 0;
+    in >> magic >> version;
+    if (!in || magic != kCheckpointMagic || version != kCheckpointVersion) {
+        error = path + " is not a checkpoint file";
+        return false;
+    }
+
+    int symmetry = 0;
+    int countOnly = 0;
+    std::string format;
+    std::size_t bySecondCount = 0;
+    std::size_t taskCount = 0;
+
+    bool ok = expect("n") && (in >> cp.n) &&
+              expect("symmetry") && (in >> symmetry) &&
+              expect("count_only") && (in >> countOnly) &&
+              expect("format") && (in >> format) &&
+              expect("output_offset") && (in >> cp.outputOffset) &&
+              expect("sequences") && (in >> cp.sequences) &&
+              expect("nodes") && (in >> cp.nodes) &&
+              expect("by_second") && (in >> bySecondCount);
+    ok = ok && parse_seq_format(format, cp.format);
+
+    cp.bySecond.assign(ok ? bySecondCount : 0, 0);
+    for (std::size_t i = 0; ok && i < bySecondCount; ++i) {
+        ok = static_cast<bool>(in >> cp.bySecond[i]);
+    }
+
+    ok = ok && expect("tasks") && (in >> taskCount);
+    cp.tasks.clear();
+    for (std::size_t i = 0; ok && i < taskCount; ++i) {
+        SearchTask task;
+        std::size_t prefixLength = 0;
+        ok = static_cast<bool>(in >> task.first >> task.last >> prefixLength);
+        task.prefix.resize(ok ? prefixLength : 0);
+        for (std::size_t k = 0; ok && k < prefixLength; ++k) {
+            ok = static_cast<bool>(in >> task.prefix[k]);
+        }
+        ok = ok && !task.prefix.empty() && task.prefix[0] == 0;
+        cp.tasks.push_back(std::move(task));
+    }
+
+    if (!ok) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+    cp.symmetry = symmetry != 0;
+    cp.countOnly = countOnly != 0;
+    return true;
+}
+
+Checkpointer::Checkpointer(std::string path,
+                           double intervalSeconds,
+                           Checkpoint base,
+                           WorkStealingPool& pool,
+                           const std::vector<SearchCounts>& workerCounts,
+                           const std::atomic<std::size_t>& sequencesWritten,
+                           SeqFileWriter* writer)
+    : path_(std::move(path)),
+      intervalSeconds_(intervalSeconds),
+      base_(std::move(base)),
+      pool_(pool),
+      workerCounts_(workerCounts),
+      sequencesWritten_(sequencesWritten),
+      writer_(writer) {}
+
+Checkpointer::~Checkpointer() {
+    stop();
+}
+
+/**
+ * @brief Start the background thread.
+ *
+ * @return void
+ */
+void Checkpointer::start() {
+    thread_ = std::thread(&Checkpointer::run, this);
+}
+
+/**
+ * @brief Stop the background thread. Must be called once the workers have finished.
+ *
+ * @return void
+ */
+void Checkpointer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief Take a checkpoint every interval until stopped or the search finishes.
+ *
+ * @return void
+ */
+void Checkpointer::run() {
+    const auto interval = std::chrono::duration<double>(intervalSeconds_);
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!cv_.wait_for(lock, interval, [&] { return stopping_; })) {
+        lock.unlock();
+        const bool more = take();
+        lock.lock();
+        if (!more) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Take one checkpoint.
+ *
+ * @return true If a checkpoint was taken; false if the search had already finished.
+ *
+ * @details The output stream is flushed from this thread while the output thread is
+ * idle: every worker is parked, and the writer has counted (after writing) every
+ * sequence the workers reported, so nothing else touches the stream until resume().
+ */
+bool Checkpointer::take() {
+    Checkpoint cp = base_;
+    if (!pool_.pause(cp.tasks)) {
+        return false;
+    }
+
+    std::size_t found = 0;
+    for (const SearchCounts& counts : workerCounts_) {
+        found += counts.sequences;
+        cp.nodes += counts.nodes;
+        for (std::size_t v = 0; v < counts.bySecond.size() && v < cp.bySecond.size(); ++v) {
+            cp.bySecond[v] += counts.bySecond[v];
+        }
+    }
+    cp.sequences += found;
+
+    if (writer_) {
+        while (sequencesWritten_.load(std::memory_order_acquire) < found) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        // The output thread is idle until the pool resumes, so its buffer can be flushed from here
+        writer_->flush();
+        cp.outputOffset = static_cast<std::uint64_t>(writer_->position());
+    }
+
+    pool_.resume();
+
+    // Results were lost, so there is no consistent state to save; the previous checkpoint stays
+    if (writer_ && writer_->failed()) {
+        return true;
+    }
+
+    std::string error;
+    if (save_checkpoint(path_, cp, error)) {
+        ++written_;
+    } else {
+        ++failed_;
+        lastError_ = error;
+    }
+    return true;
+}
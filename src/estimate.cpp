@@ -0,0 +1,277 @@
+/**
+ * @file src/estimate.cpp
+ *
+ * @brief Implementation of the search-tree size estimator.
+ */
+
+#include "estimate.h"
+#include "search_state.h"
+#include "fixed_search_state.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+/**
+ * @brief How often sample_node_rate() checks whether its time is up.
+ */
+static constexpr std::chrono::milliseconds kRatePollInterval{10};
+
+/**
+ * @brief Running mean and variance of one probe statistic (Welford's method).
+ */
+struct RunningStats {
+    std::size_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double x) {
+        ++count;
+        const double delta = x - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (x - mean);
+    }
+
+    // Half-width of the 95% confidence interval of the mean
+    double error() const {
+        if (count < 2) {
+            return 0.0;
+        }
+        const double variance = m2 / static_cast<double>(count - 1);
+        return kConfidenceZ * std::sqrt(variance / static_cast<double>(count));
+    }
+};
+
+/**
+ * @brief Whether dfs_search() would descend into the prefix just pushed.
+ *
+ * @details The same cuts, in the same order, as the loop in dfs_search(): complete
+ * sequences are leaves, then symmetry, then lookahead.
+ */
+template <typename State>
+static bool descends(const State& state, bool symmetry, bool lookahead) {
+    if (state.complete()) {
+        return false;
+    }
+    if (symmetry && !state.canonical_possible()) {
+        return false;
+    }
+    return !(lookahead && state.lookahead() != PruneReason::None);
+}
+
+/**
+ * @brief Run one probe from the prefix {0, second} and return its node and sequence estimates.
+ *
+ * @param state A state holding {0, second}, which dfs_search() would descend into; restored on return.
+ * @param symmetry Whether only canonical sequences are searched, each counting for two.
+ * @param lookahead Whether prefixes that cannot be completed are cut.
+ * @param rng Source of the random choices.
+ * @param children Scratch buffer for the children to choose from.
+ * @param expanded Incremented by the nodes this probe expands itself.
+ *
+ * @return std::pair<double, double> Estimated nodes and sequences below {0, second}.
+ */
+template <typename State>
+static std::pair<double, double> run_probe(State& state, bool symmetry, bool lookahead, std::mt19937_64& rng,
+                                           std::vector<int>& children, std::size_t& expanded) {
+    const int base = state.size();
+    const double perSequence = symmetry ? 2.0 : 1.0;
+    double weight = 1.0;
+    double nodes = 0.0;
+    double sequences = 0.0;
+
+    while (true) {
+        children.clear();
+        int valid = 0;
+        int complete = 0;
+        typename State::Candidates candidates = state.candidates(0);
+        int candidate;
+        while (candidates.next(candidate)) {
+            ++valid;
+            state.push(candidate);
+            if (state.complete()) {
+                ++complete;
+            } else if (descends(state, symmetry, lookahead)) {
+                children.push_back(candidate);
+            }
+            state.pop();
+        }
+        expanded += static_cast<std::size_t>(valid);
+        nodes += weight * valid;
+        sequences += weight * complete * perSequence;
+
+        if (children.empty()) {
+            break;
+        }
+        std::uniform_int_distribution<std::size_t> pick(0, children.size() - 1);
+        weight *= static_cast<double>(children.size());
+        state.push(children[pick(rng)]);
+    }
+
+    while (state.size() > base) {
+        state.pop();
+    }
+    return {nodes, sequences};
+}
+
+/**
+ * @brief Estimate the nodes and sequences of a search, with the given state type.
+ *
+ * @tparam State SearchState, or the FixedSearchState specialized for cfg.n.
+ *
+ * @details See estimate_search_tree() for the parameters.
+ */
+template <typename State>
+static SearchEstimate estimate_with(const NS1D0Config& cfg, const SearchOptions& opts,
+                                    std::size_t probes, std::uint64_t seed) {
+    // Sequences of length 2 are their own mirror, as in run_worker()
+    const bool symmetry = opts.symmetry && cfg.targetLength > 2;
+    SearchEstimate estimate;
+    State state(cfg);
+    std::vector<int> children;
+    children.reserve(cfg.n);
+
+    for (const SearchTask& task : initial_search_tasks(cfg)) {
+        SubtreeEstimate subtree;
+        subtree.second = task.first;
+        // One stream per second element, so a subtree's estimate does not depend on the others
+        std::mt19937_64 rng(seed + static_cast<std::uint64_t>(task.first));
+
+        for (int v : task.prefix) {
+            state.push(v);
+        }
+        state.push(task.first);
+
+        // {0, a_1} is a node of the search itself; below it the tree is fixed, so probes only run there
+        if (state.complete()) {
+            subtree.nodes = 1.0;
+            subtree.sequences = symmetry ? 2.0 : 1.0;
+        } else if (!descends(state, symmetry, opts.lookahead)) {
+            subtree.nodes = 1.0;
+        } else {
+            RunningStats nodes;
+            RunningStats sequences;
+            for (std::size_t p = 0; p < probes; ++p) {
+                const auto [n, s] = run_probe(state, symmetry, opts.lookahead, rng, children, estimate.probeNodes);
+                nodes.add(n);
+                sequences.add(s);
+            }
+            subtree.probes = probes;
+            subtree.nodes = 1.0 + nodes.mean;
+            subtree.nodesError = nodes.error();
+            subtree.sequences = sequences.mean;
+            subtree.sequencesError = sequences.error();
+        }
+
+        while (state.size() > 0) {
+            state.pop();
+        }
+        estimate.subtrees.push_back(subtree);
+    }
+
+    // Subtrees are probed independently, so their variances add
+    double nodesVariance = 0.0;
+    double sequencesVariance = 0.0;
+    for (const SubtreeEstimate& subtree : estimate.subtrees) {
+        estimate.nodes += subtree.nodes;
+        estimate.sequences += subtree.sequences;
+        nodesVariance += subtree.nodesError * subtree.nodesError;
+        sequencesVariance += subtree.sequencesError * subtree.sequencesError;
+    }
+    estimate.nodesError = std::sqrt(nodesVariance);
+    estimate.sequencesError = std::sqrt(sequencesVariance);
+    return estimate;
+}
+
+/**
+ * @brief Estimate the nodes and sequences of a search with random probes.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; symmetry, lookahead and the kernel choice shape the tree.
+ * @param probes Probes per second element.
+ * @param seed Seed of the random choices; the same seed gives the same estimate.
+ *
+ * @return SearchEstimate The estimates, per second element and in total.
+ *
+ * @details The node count matches what dfs_search() counts: every valid child of every
+ * expanded node, including the ones cut by symmetry or the lookahead. The root {0} is
+ * not a node, as in the search.
+ */
+SearchEstimate estimate_search_tree(const NS1D0Config& cfg,
+                                    const SearchOptions& opts,
+                                    std::size_t probes,
+                                    std::uint64_t seed) {
+    const auto start = std::chrono::steady_clock::now();
+    SearchEstimate estimate;
+    with_search_state(cfg.n, opts.specialized, [&](auto tag) {
+        using State = typename decltype(tag)::type;
+        estimate = estimate_with<State>(cfg, opts, std::max<std::size_t>(probes, 1), seed);
+    });
+    estimate.probeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return estimate;
+}
+
+/**
+ * @brief Measure the node rate of the real search on workerCount workers.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; the run is count-only whatever opts says.
+ * @param workerCount Number of worker threads.
+ * @param seconds How long to run before cancelling the search.
+ *
+ * @return NodeRate What the run did.
+ *
+ * @details The run starts from the initial tasks exactly like a real one, so the
+ * rate includes scheduling and splitting. Cancelling it drops the rest of the tree.
+ */
+NodeRate sample_node_rate(const NS1D0Config& cfg, const SearchOptions& opts, int workerCount, double seconds) {
+    using Clock = std::chrono::steady_clock;
+    SearchOptions countOpts = opts;
+    countOpts.countOnly = true;
+    countOpts.breakdown = false;
+    countOpts.ordered = false;
+    countOpts.onResult = nullptr;
+
+    const auto start = Clock::now();
+    WorkStealingPool pool(workerCount);
+    const std::vector<SearchTask> tasks = initial_search_tasks(cfg);
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        pool.push(static_cast<int>(i % workerCount), tasks[i]);
+    }
+
+    ResultChannel unused;
+    std::atomic<std::size_t> nodesExpanded{0};
+    std::atomic<int> running{workerCount};
+    std::vector<SearchCounts> workerCounts(workerCount);
+    std::vector<LiveProgress> liveProgress(workerCount);
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([&, i] {
+            search_worker(i, pool, cfg, countOpts, unused, workerCounts[i], nodesExpanded, liveProgress[i]);
+            running.fetch_sub(1);
+        });
+    }
+
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    while (running.load() > 0 && Clock::now() < deadline) {
+        std::this_thread::sleep_for(kRatePollInterval);
+    }
+    // Every worker exited on its own, so nothing was left to cancel
+    const bool complete = running.load() == 0;
+    pool.cancel();
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    NodeRate rate;
+    rate.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    rate.nodes = nodesExpanded.load();
+    for (const SearchCounts& c : workerCounts) {
+        rate.sequences += c.sequences;
+    }
+    rate.complete = complete;
+    return rate;
+}
@@ -15,12 +15,427 @@
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
 
 #include "../include/ns1d0.h"
-#include "../include/channel.h"
+#include "../include/batch_channel.h"
+#include "../include/work_stealing.h"
+#include "../include/checkpoint.h"
+#include "../include/progress.h"
+#include "../include/fixed_search_state.h"
+#include "../include/meet_in_middle.h"
+#include "../include/pair_search.h"
+#include "../include/shard.h"
+#include "../include/reorder.h"
+#include "../include/ns1d0_api.h"
+#include "../include/alloc_counter.h"
+#include "../include/estimate.h"
+
+#include <unistd.h>
+
+/**
+ * @brief Seed of the --estimate probes, fixed so estimates can be repeated.
+ */
+static constexpr std::uint64_t kEstimateSeed = 0x4e53314430ull;
+
+/**
+ * @struct Options
+ * 
+ * @brief Optional command line settings.
+ * 
+ * @var queueCapacity High-water mark of the result channel in sequences; 0 means unbounded.
+ * @var search Options passed on to the search workers, including the layout of the output file.
+ * @var checkpointPath File to write periodic checkpoints to; empty for none.
+ * @var checkpointInterval Seconds between checkpoints.
+ * @var resumePath Checkpoint to resume from; empty to start from scratch.
+ * @var progressInterval Seconds between progress reports; 0 for none.
+ * @var statsJsonPath File to write the run summary to as JSON; empty for none.
+ * @var meetInMiddle Join half-sequences instead of searching whole ones depth-first.
+ * @var mitmMemory Bytes the meet-in-the-middle index may use.
+ * @var shard The part of a sharded run to search; shard.count is 0 for the whole search.
+ * @var manifestPath File to write the shard manifest to; defaults to the output file plus ".manifest".
+ * @var reorderMemory Bytes of results an ordered run may hold back before spilling them to disk.
+ * @var estimate Estimate the size and running time of the search instead of running it.
+ * @var probes Random probes per second element for the estimate.
+ * @var estimateSeconds How long the estimate runs the real search to measure the node rate.
+ * @var limit Stop the search once this many sequences have been found; 0 for all of them.
+ * @var engine Which search engine the workers run.
+ * @var threads Worker threads; 0 for one per hardware thread.
+ */
+struct Options {
+    std::size_t queueCapacity = 1 << 16;
+    SearchOptions search;
+    std::string checkpointPath;
+    double checkpointInterval = 60.0;
+    std::string resumePath;
+    double progressInterval = 0.0;
+    std::string statsJsonPath;
+    bool meetInMiddle = false;
+    std::size_t mitmMemory = std::size_t{1024} << 20;
+    ShardSpec shard;
+    std::string manifestPath;
+    std::size_t reorderMemory = std::size_t{256} << 20;
+    bool estimate = false;
+    std::size_t probes = 20000;
+    double estimateSeconds = 1.0;
+    std::size_t limit = 0;
+    SearchEngine engine = SearchEngine::Dfs;
+    int threads = 0;
+};
+
+/**
+ * @brief Print the command line usage.
+ * 
+ * @param prog The program name.
+ * 
+ * @return void
+ */
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <n> <output_file> [options]" << std::endl;
+    std::cerr << "       " << prog << " <n> --count-only [--breakdown] [options]" << std::endl;
+    std::cerr << "       " << prog << " <n> --estimate [--probes k] [--estimate-seconds s] [options]" << std::endl;
+    std::cerr << "       " << prog << " --range <lo:hi> <output_pattern> [options]   (every odd n in [lo, hi]; {n} in the pattern is replaced by n)" << std::endl;
+    std::cerr << "       " << prog << " --range <lo:hi> --count-only [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --threads <k>         number of worker threads (default: one per hardware thread, at least 2)" << std::endl;
+    std::cerr << "  --queue-capacity <k>  block workers once k results are waiting to be written (0 = unbounded)" << std::endl;
+    std::cerr << "  --format <f>          output format: text (default), bytes or packed" << std::endl;
+    std::cerr << "  --count-only          only count sequences; no output file is written" << std::endl;
+    std::cerr << "  --breakdown           with --count-only, also count per second element" << std::endl;
+    std::cerr << "  --no-symmetry         search every sequence instead of one per mirror pair" << std::endl;
+    std::cerr << "  --generic             use the generic search kernel even if one is compiled for n" << std::endl;
+    std::cerr << "  --no-lookahead        do not prune prefixes that provably cannot be completed" << std::endl;
+    std::cerr << "  --checkpoint <file>   periodically save the search frontier to file" << std::endl;
+    std::cerr << "  --checkpoint-interval <s>  seconds between checkpoints (default 60)" << std::endl;
+    std::cerr << "  --resume <file>       continue an interrupted run from its checkpoint" << std::endl;
+    std::cerr << "  --progress <s>        print rates and an estimated completion time every s seconds" << std::endl;
+    std::cerr << "  --stats-json <file>   write counters and timings of the run to file as JSON" << std::endl;
+    std::cerr << "  --meet-in-middle      join half-sequences from both ends instead of a plain depth-first search" << std::endl;
+    std::cerr << "  --mitm-memory <MiB>   memory for the half-sequence index (default 1024); the rest is searched depth-first" << std::endl;
+    std::cerr << "  --shard <i/k>         search only shard i of k (0 <= i < k); merge the shards with shardmerge" << std::endl;
+    std::cerr << "  --manifest <file>     where to write the shard manifest (default: output file + .manifest)" << std::endl;
+    std::cerr << "  --ordered             write the sequences in lexicographic order; implies --no-symmetry" << std::endl;
+    std::cerr << "  --reorder-memory <MiB>  results held back by --ordered before spilling to disk (default 256)" << std::endl;
+    std::cerr << "  --limit <k>           stop once k sequences are found (k = 1: does any exist?)" << std::endl;
+    std::cerr << "  --engine <e>          search engine: dfs (default) or pairs (difference pairs, both ends, most constrained first)" << std::endl;
+    std::cerr << "  --estimate            predict nodes, sequences and time with random probes instead of searching" << std::endl;
+    std::cerr << "  --probes <k>          probes per second element for --estimate (default 20000)" << std::endl;
+    std::cerr << "  --estimate-seconds <s>  how long --estimate times the real search (default 1)" << std::endl;
+}
+
+/**
+ * @brief Parse the options that follow the positional arguments.
+ * 
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param first Index of the first option.
+ * @param opts Receives the parsed options.
+ * 
+ * @return true If every option was understood.
+ */
+static bool parse_options(int argc, char* argv[], int first, Options& opts) {
+    for (int i = first; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            opts.threads = std::atoi(argv[++i]);
+            if (opts.threads <= 0) {
+                std::cerr << "Error: The number of threads must be positive." << std::endl;
+                return false;
+            }
+        } else if (arg == "--queue-capacity" && i + 1 < argc) {
+            opts.queueCapacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (!parse_seq_format(argv[++i], opts.search.format)) {
+                std::cerr << "Error: Unknown output format '" << argv[i] << "'." << std::endl;
+                return false;
+            }
+        } else if (arg == "--count-only") {
+            opts.search.countOnly = true;
+        } else if (arg == "--breakdown") {
+            opts.search.breakdown = true;
+        } else if (arg == "--no-symmetry") {
+            opts.search.symmetry = false;
+        } else if (arg == "--generic") {
+            opts.search.specialized = false;
+        } else if (arg == "--no-lookahead") {
+            opts.search.lookahead = false;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            opts.checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            opts.checkpointInterval = std::atof(argv[++i]);
+            if (opts.checkpointInterval <= 0.0) {
+                std::cerr << "Error: The checkpoint interval must be positive." << std::endl;
+                return false;
+            }
+        } else if (arg == "--resume" && i + 1 < argc) {
+            opts.resumePath = argv[++i];
+        } else if (arg == "--progress" && i + 1 < argc) {
+            opts.progressInterval = std::atof(argv[++i]);
+            if (opts.progressInterval <= 0.0) {
+                std::cerr << "Error: The progress interval must be positive." << std::endl;
+                return false;
+            }
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            opts.statsJsonPath = argv[++i];
+        } else if (arg == "--meet-in-middle") {
+            opts.meetInMiddle = true;
+        } else if (arg == "--mitm-memory" && i + 1 < argc) {
+            opts.mitmMemory = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--shard" && i + 1 < argc) {
+            if (!parse_shard_spec(argv[++i], opts.shard)) {
+                std::cerr << "Error: The shard must be given as i/k with 0 <= i < k." << std::endl;
+                return false;
+            }
+        } else if (arg == "--manifest" && i + 1 < argc) {
+            opts.manifestPath = argv[++i];
+        } else if (arg == "--ordered") {
+            opts.search.ordered = true;
+        } else if (arg == "--reorder-memory" && i + 1 < argc) {
+            opts.reorderMemory = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--limit" && i + 1 < argc) {
+            opts.limit = std::strtoull(argv[++i], nullptr, 10);
+            if (opts.limit == 0) {
+                std::cerr << "Error: The limit must be positive." << std::endl;
+                return false;
+            }
+        } else if (arg == "--engine" && i + 1 < argc) {
+            if (!parse_search_engine(argv[++i], opts.engine)) {
+                std::cerr << "Error: Unknown search engine '" << argv[i] << "'." << std::endl;
+                return false;
+            }
+        } else if (arg == "--estimate") {
+            opts.estimate = true;
+        } else if (arg == "--probes" && i + 1 < argc) {
+            opts.probes = std::strtoull(argv[++i], nullptr, 10);
+            if (opts.probes == 0) {
+                std::cerr << "Error: The number of probes must be positive." << std::endl;
+                return false;
+            }
+        } else if (arg == "--estimate-seconds" && i + 1 < argc) {
+            opts.estimateSeconds = std::atof(argv[++i]);
+            if (opts.estimateSeconds <= 0.0) {
+                std::cerr << "Error: The estimate time must be positive." << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error: Unknown or incomplete option '" << arg << "'." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief The output file of one n of a sweep.
+ * 
+ * @param pattern The output argument; {n} is replaced by n, otherwise ".n" is appended.
+ * @param n The modulus.
+ * 
+ * @return std::string The path.
+ */
+static std::string sweep_output_path(const std::string& pattern, int n) {
+    const std::size_t at = pattern.find("{n}");
+    if (at == std::string::npos) {
+        return pattern + "." + std::to_string(n);
+    }
+    return pattern.substr(0, at) + std::to_string(n) + pattern.substr(at + 3);
+}
+
+/**
+ * @brief Search every odd n of a range in one process, print a summary per n and return the exit status.
+ * 
+ * @param argc Argument count.
+ * @param argv Argument vector, with "--range" in argv[1].
+ * 
+ * @return int Exit status code.
+ * 
+ * @details All searches share one pool and one set of workers (see sweep_worker()). The
+ * tasks are seeded so the largest n run first, so the expensive searches start at once and the cheap
+ * ones fill in around them instead of leaving cores idle at the end. Each n keeps its own
+ * result channel, output thread and file, which is complete as soon as that n finishes.
+ */
+static int run_range(int argc, char* argv[]) {
+    int lo = 0;
+    int hi = 0;
+    char sep = 0;
+    if (argc < 4 || std::sscanf(argv[2], "%d%c%d", &lo, &sep, &hi) != 3 || sep != ':' ||
+        lo <= 1 || lo % 2 != 1 || hi < lo) {
+        std::cerr << "Error: The range must be lo:hi with odd lo > 1 and hi >= lo." << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    const bool haveFile = std::string(argv[3]).rfind("--", 0) != 0;
+    Options opts;
+    if (!parse_options(argc, argv, haveFile ? 4 : 3, opts)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!haveFile && !opts.search.countOnly) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (opts.meetInMiddle || opts.shard.count > 0 || !opts.checkpointPath.empty() || !opts.resumePath.empty() ||
+        opts.search.ordered || opts.estimate || opts.progressInterval > 0.0 || !opts.statsJsonPath.empty() ||
+        opts.limit > 0 || opts.engine != SearchEngine::Dfs) {
+        std::cerr << "Error: --range runs plain depth-first searches; it only takes --threads, --format, --queue-capacity,"
+                  << " --count-only, --breakdown, --no-symmetry, --generic and --no-lookahead." << std::endl;
+        return 1;
+    }
+    if (opts.search.format == SeqFormat::Bytes && hi > 256) {
+        std::cerr << "Error: The bytes format needs n <= 256; use --format packed." << std::endl;
+        return 1;
+    }
+
+    const int workerCount = worker_count(opts.threads);
+    const bool writing = haveFile && !opts.search.countOnly;
+    std::cout << "NS1D0 sweep over n = " << lo << ".." << hi << " on " << workerCount << " worker threads" << std::endl;
+
+    std::deque<SearchJob> jobs;
+    std::deque<ResultChannel> channels;
+    std::deque<std::ofstream> files;
+    std::deque<SeqFileWriter> writers;
+    std::deque<std::atomic<std::size_t>> written;
+    std::vector<std::thread> writerThreads;
+    for (int n = lo; n <= hi; n += 2) {
+        SearchJob& job = jobs.emplace_back();
+        job.cfg = ns1d0_config(n);
+        job.opts = opts.search;
+        job.channel = &channels.emplace_back(opts.queueCapacity);
+        job.counts.resize(workerCount);
+        job.live = std::vector<LiveProgress>(workerCount);
+        if (writing) {
+            const std::string path = sweep_output_path(argv[3], n);
+            std::ofstream& out = files.emplace_back(path, std::ios::binary);
+            if (!out.is_open()) {
+                std::cerr << "Error: Could not open output file " << path << "." << std::endl;
+                return 1;
+            }
+            SeqFileWriter& writer = writers.emplace_back(out, opts.search.format, n, job.cfg.targetLength, true);
+            std::atomic<std::size_t>& count = written.emplace_back(0);
+            writerThreads.emplace_back(output_thread, std::ref(*job.channel), std::ref(writer), std::ref(count),
+                                       OutputLimit{});
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Dealt round-robin, largest n last: workers pop their newest task first, so the long
+    // searches are under way from the start and the short ones fill in around them
+    WorkStealingPool pool(workerCount);
+    std::size_t dealt = 0;
+    for (int j = 0; j < static_cast<int>(jobs.size()); ++j) {
+        std::vector<SearchTask> tasks = initial_search_tasks(jobs[j].cfg);
+        jobs[j].pending.store(tasks.size());
+        if (tasks.empty()) {
+            jobs[j].finished = start;
+            jobs[j].channel->close();
+        }
+        for (SearchTask& task : tasks) {
+            task.job = j;
+            pool.push(static_cast<int>(dealt++ % workerCount), std::move(task));
+        }
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(sweep_worker, i, std::ref(pool), std::ref(jobs));
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    for (auto& t : writerThreads) {
+        t.join();
+    }
+    const double makespan = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool writeFailed = false;
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        const SearchJob& job = jobs[j];
+        SearchCounts total;
+        total.bySecond.assign(job.opts.countOnly && job.opts.breakdown ? job.cfg.n : 0, 0);
+        for (const SearchCounts& c : job.counts) {
+            total.sequences += c.sequences;
+            for (std::size_t v = 0; v < c.bySecond.size() && v < total.bySecond.size(); v++) {
+                total.bySecond[v] += c.bySecond[v];
+            }
+        }
+        std::cout << "n = " << job.cfg.n << ": " << total.sequences << " sequences, "
+                  << job.nodes.load() << " nodes, finished after "
+                  << std::chrono::duration<double>(job.finished - start).count() << " s";
+        if (writing && !writers[j].failed()) {
+            std::cout << ", written to " << sweep_output_path(argv[3], job.cfg.n);
+        }
+        std::cout << std::endl;
+        if (writing && writers[j].failed()) {
+            std::cerr << "Error: Could not write " << sweep_output_path(argv[3], job.cfg.n)
+                      << "; the output is incomplete." << std::endl;
+            writeFailed = true;
+        }
+        for (std::size_t v = 0; v < total.bySecond.size(); v++) {
+            if (total.bySecond[v] > 0) {
+                std::cout << "  second element " << v << ": " << total.bySecond[v] << std::endl;
+            }
+        }
+    }
+    std::cout << "Sweep time: " << makespan << " s" << std::endl;
+    return writeFailed ? 1 : 0;
+}
+
+/**
+ * @brief Estimate the size and running time of a search, print the report and return the exit status.
+ * 
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts The parsed options.
+ * @param workerCount Number of workers the real search would run with.
+ * 
+ * @return int Exit status code.
+ * 
+ * @details Probes give the nodes and sequences (see estimate.h); a short timed run of the real
+ * search gives the node rate that turns them into a wall time. Subtrees are listed heaviest
+ * first, which is the order worth splitting them in across machines.
+ */
+static int run_estimate(const NS1D0Config& cfg, const Options& opts, int workerCount) {
+    const SearchEstimate est = estimate_search_tree(cfg, opts.search, opts.probes, kEstimateSeed);
+    std::cout << "Estimate from " << opts.probes << " probes per second element ("
+              << est.probeNodes << " nodes, " << est.probeSeconds << " s), 95% confidence:" << std::endl;
+    std::cout << "  nodes:     " << est.nodes << " +/- " << est.nodesError << std::endl;
+    std::cout << "  sequences: " << est.sequences << " +/- " << est.sequencesError << std::endl;
+
+    const NodeRate rate = sample_node_rate(cfg, opts.search, workerCount, opts.estimateSeconds);
+    if (rate.complete) {
+        std::cout << "The search finished while being timed: " << rate.nodes << " nodes, "
+                  << rate.sequences << " sequences in " << rate.seconds << " s" << std::endl;
+    } else {
+        const double perSecond = rate.nodes / rate.seconds;
+        std::cout << "Node rate on " << workerCount << " workers: " << perSecond << " nodes/s"
+                  << " (timed " << rate.seconds << " s)" << std::endl;
+        std::cout << "  time:      " << est.nodes / perSecond << " s (95%: "
+                  << std::max(0.0, est.nodes - est.nodesError) / perSecond << " to "
+                  << (est.nodes + est.nodesError) / perSecond << " s)" << std::endl;
+    }
+
+    std::vector<SubtreeEstimate> heaviest = est.subtrees;
+    std::sort(heaviest.begin(), heaviest.end(),
+              [](const SubtreeEstimate& a, const SubtreeEstimate& b) { return a.nodes > b.nodes; });
+    std::cout << "Subtrees by second element, heaviest first:" << std::endl;
+    for (const SubtreeEstimate& sub : heaviest) {
+        std::cout << "  " << sub.second << ": " << sub.nodes << " +/- " << sub.nodesError << " nodes ("
+                  << (est.nodes > 0.0 ? 100.0 * sub.nodes / est.nodes : 0.0) << "%), "
+                  << sub.sequences << " +/- " << sub.sequencesError << " sequences" << std::endl;
+    }
+    return 0;
+}
 
 /**
  * @brief Entry point for the NS1D0 sequence search program.
@@ -34,9 +449,25 @@
  */
 int main(int argc, char* argv[]) {
 
+    // A sweep over several n has its own driver
+    if (argc > 1 && std::string(argv[1]) == "--range") {
+        return run_range(argc, argv);
+    }
+
     // Input checkers
     if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <n> <output_file>" << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    // The output file is optional when only counting
+    const bool haveFile = std::string(argv[2]).rfind("--", 0) != 0;
+    Options opts;
+    if (!parse_options(argc, argv, haveFile ? 3 : 2, opts)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!haveFile && !opts.search.countOnly && !opts.estimate) {
+        print_usage(argv[0]);
         return 1;
     }
     // Parse n input
@@ -45,72 +476,418 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: n must be an odd integer greater than 1." << std::endl;
         return 1;
     }
-    // Open output file
-    const char* filename = argv[2];
-    std::ofstream outFile(filename);
-    if (!outFile.is_open()) {
+    if (opts.meetInMiddle && (!opts.checkpointPath.empty() || !opts.resumePath.empty() || opts.progressInterval > 0.0)) {
+        std::cerr << "Error: --meet-in-middle cannot be combined with --checkpoint, --resume or --progress." << std::endl;
+        return 1;
+    }
+    if (opts.search.ordered && (opts.meetInMiddle || !opts.checkpointPath.empty() || !opts.resumePath.empty())) {
+        std::cerr << "Error: --ordered cannot be combined with --meet-in-middle, --checkpoint or --resume." << std::endl;
+        return 1;
+    }
+    if (opts.search.ordered && !opts.search.countOnly) {
+        // A mirror belongs to a different subtree, so it cannot be written next to its sequence
+        opts.search.symmetry = false;
+    }
+    if (opts.limit > 0 && (opts.meetInMiddle || !opts.checkpointPath.empty() || !opts.resumePath.empty() ||
+                           opts.search.ordered || opts.search.breakdown || opts.shard.count > 0)) {
+        std::cerr << "Error: --limit cannot be combined with --meet-in-middle, --checkpoint, --resume,"
+                  << " --ordered, --breakdown or --shard." << std::endl;
+        return 1;
+    }
+    if (opts.estimate && (opts.meetInMiddle || opts.shard.count > 0 || !opts.checkpointPath.empty() ||
+                          !opts.resumePath.empty() || opts.search.ordered)) {
+        std::cerr << "Error: --estimate predicts a plain depth-first search; drop the other run options." << std::endl;
+        return 1;
+    }
+    if (opts.engine == SearchEngine::Pairs) {
+        if (opts.meetInMiddle || opts.shard.count > 0 || !opts.checkpointPath.empty() || !opts.resumePath.empty() ||
+            opts.progressInterval > 0.0 || opts.search.ordered || opts.estimate) {
+            std::cerr << "Error: --engine pairs cannot be combined with --meet-in-middle, --shard, --checkpoint,"
+                      << " --resume, --progress, --ordered or --estimate." << std::endl;
+            return 1;
+        }
+        if (n > kMaxPairSearchN) {
+            std::cerr << "Error: --engine pairs handles n up to " << kMaxPairSearchN << "." << std::endl;
+            return 1;
+        }
+        // The engine finds every sequence itself; there are no mirrors to add
+        opts.search.symmetry = false;
+    }
+    if (opts.shard.count > 0 && opts.meetInMiddle) {
+        std::cerr << "Error: --shard cannot be combined with --meet-in-middle." << std::endl;
+        return 1;
+    }
+    if (opts.shard.count > 0 && opts.manifestPath.empty()) {
+        if (opts.search.countOnly) {
+            std::cerr << "Error: A count-only shard needs --manifest." << std::endl;
+            return 1;
+        }
+        opts.manifestPath = std::string(argv[2]) + ".manifest";
+    }
+    if (opts.search.format == SeqFormat::Bytes && n > 256) {
+        std::cerr << "Error: The bytes format needs n <= 256; use --format packed." << std::endl;
+        return 1;
+    }
+    // Load the checkpoint to resume from; it must describe the same search
+    Checkpoint resumeFrom;
+    const bool resuming = !opts.resumePath.empty();
+    if (resuming) {
+        std::string error;
+        if (!load_checkpoint(opts.resumePath, resumeFrom, error)) {
+            std::cerr << "Error: " << error << "." << std::endl;
+            return 1;
+        }
+        if (resumeFrom.n != n ||
+            resumeFrom.symmetry != opts.search.symmetry ||
+            resumeFrom.countOnly != opts.search.countOnly ||
+            (!opts.search.countOnly && resumeFrom.format != opts.search.format)) {
+            std::cerr << "Error: The checkpoint was taken with a different n or different options." << std::endl;
+            return 1;
+        }
+        if (opts.checkpointPath.empty()) {
+            opts.checkpointPath = opts.resumePath; // keep checkpointing where we left off
+        }
+    }
+
+    // Open output file (not used when only counting)
+    const char* filename = haveFile && !opts.search.countOnly && !opts.estimate ? argv[2] : nullptr;
+    std::ofstream outFile;
+    if (filename && resuming) {
+        // Drop whatever was written after the checkpoint; that part of the tree is searched again
+        if (truncate(filename, static_cast<off_t>(resumeFrom.outputOffset)) != 0) {
+            std::cerr << "Error: Could not truncate output file to the checkpoint offset." << std::endl;
+            return 1;
+        }
+        outFile.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+        outFile.seekp(0, std::ios::end);
+    } else if (filename) {
+        outFile.open(filename, std::ios::binary);
+    }
+    if (filename && !outFile.is_open()) {
         std::cerr << "Error: Could not open output file." << std::endl;
         return 1;
     }
 
     // Configuration setup
-    NS1D0Config cfg;
-    cfg.n = n;
-    cfg.targetLength = (n - 1) / 2 + 1;
-    cfg.forbidden = (n + 1) / 2; // ceil(n/2) since n is odd
+    const NS1D0Config cfg = ns1d0_config(n);
 
     std::cout << "NS1D0(" << n << ") search" << std::endl;
     std::cout << "Target sequence length: " << cfg.targetLength << std::endl;
     std::cout << "Forbidden value (ceil(n/2)): " << cfg.forbidden << std::endl;
+    if (opts.engine == SearchEngine::Pairs) {
+        std::cout << "Search engine: difference pairs, from both ends, most constrained end first" << std::endl;
+    } else {
+        std::cout << "Search kernel: "
+                  << (opts.search.specialized && has_specialized_state(n) ? "specialized for n = " + std::to_string(n) : "generic")
+                  << std::endl;
+    }
+
+    // Worker threads
+    const int workerCount = worker_count(opts.threads);
+
+    if (opts.estimate) {
+        return run_estimate(cfg, opts, workerCount);
+    }
+
+    // Task pool shared by the workers, seeded with one task per second element,
+    // with the unexplored frontier of the checkpoint, or with the partitions the
+    // meet-in-the-middle index had no room for
+    WorkStealingPool pool(workerCount);
 
-    // Channel and atomic counter for solutions
-    Channel<std::vector<int>> resultChannel;
+    // Channel and atomic counter for solutions, bounded so memory stays flat if output is slow
+    ResultChannel resultChannel(opts.queueCapacity);
 
     // Progress Counter
     std::atomic<std::size_t> nodesExpanded{0};
     std::atomic<std::size_t> sequences_found{0};
 
-    // Output thread
-    std::thread writerThread(output_thread,
-                             std::ref(resultChannel),
-                             std::ref(outFile),
-                             std::ref(sequences_found));
+    // Output thread; in count-only mode nothing goes through the channel and there is no writer
+    std::optional<SeqFileWriter> writer;
+    std::optional<ReorderBuffer> reorder;
+    std::thread writerThread;
+    if (filename) {
+        writer.emplace(outFile, opts.search.format, cfg.n, cfg.targetLength, !resuming);
+        if (opts.search.ordered) {
+            reorder.emplace(*writer, opts.reorderMemory, std::string(filename) + ".reorder");
+            writerThread = std::thread(ordered_output_thread,
+                                       std::ref(resultChannel),
+                                       std::ref(*reorder),
+                                       std::ref(*writer),
+                                       std::ref(sequences_found));
+        } else {
+            writerThread = std::thread(output_thread,
+                                       std::ref(resultChannel),
+                                       std::ref(*writer),
+                                       std::ref(sequences_found),
+                                       OutputLimit{opts.limit, &pool});
+        }
+    }
 
-    // Worker threads
-    unsigned int hw = std::thread::hardware_concurrency();
-    int workerCount = (hw = 0 ? 4 : static_cast<int>(hw));
-    if (workerCount < 2) workerCount = 2; // min required for homework 2 threads.
+    // Writing with a limit: small batches, so the k-th sequence does not sit in a worker's
+    // slab while the others look for more
+    if (opts.limit > 0) {
+        const std::size_t share = (opts.limit + workerCount - 1) / static_cast<std::size_t>(workerCount);
+        opts.search.resultBatch = std::min(opts.search.resultBatch, share);
+    }
+
+    // Counting with a limit: workers hand every sequence to a shared counter, and the
+    // one that reaches the limit cancels the search
+    std::atomic<std::size_t> limitCounted{0};
+    if (opts.limit > 0 && opts.search.countOnly) {
+        opts.search.onResult = [&limitCounted, limit = opts.limit](const int*, std::size_t) {
+            return limitCounted.fetch_add(1, std::memory_order_relaxed) + 1 < limit;
+        };
+    }
 
     std::cout << "Spawning " << workerCount << " worker threads..." << std::endl;
 
+    const auto searchStart = std::chrono::steady_clock::now();
+    const std::size_t allocationsBefore = heap_allocations();
+
+    SearchCounts mitmCounts;
+    MeetInMiddleStats mitmStats;
+    std::vector<SearchTask> tasks;
+    std::vector<std::vector<int>> shardPrefixes;
+    int shardDepth = 0;
+    if (opts.shard.count > 0) {
+        shardPrefixes = shard_prefixes(cfg, opts.shard, shardDepth);
+        std::cout << "Shard " << opts.shard.index << "/" << opts.shard.count << ": "
+                  << shardPrefixes.size() << " prefixes of length " << shardDepth << std::endl;
+    }
+    if (resuming) {
+        tasks = resumeFrom.tasks;
+        std::cout << "Resuming " << tasks.size() << " tasks from " << opts.resumePath << std::endl;
+    } else if (opts.meetInMiddle) {
+        tasks = meet_in_middle_search(cfg, opts.search, opts.mitmMemory, workerCount,
+                                      resultChannel, mitmCounts, mitmStats);
+        // The join finds every sequence of its partitions, so the rest must be searched without symmetry
+        opts.search.symmetry = false;
+    } else if (opts.engine == SearchEngine::Pairs) {
+        tasks = initial_pair_tasks(cfg);
+    } else if (opts.shard.count > 0) {
+        for (const std::vector<int>& prefix : shardPrefixes) {
+            tasks.push_back(prefix_task(prefix));
+        }
+    } else {
+        tasks = initial_search_tasks(cfg);
+    }
+    if (reorder) {
+        announce_tasks(resultChannel, tasks);
+    }
+    double remaining = 0.0; // share of the tree the tasks cover, for progress estimates
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        pool.push(static_cast<int>(i % workerCount), tasks[i]);
+        remaining += task_weight(tasks[i], cfg);
+    }
+
     std::vector<std::thread> workers;
     workers.reserve(workerCount);
+    std::vector<SearchCounts> workerCounts(workerCount);
+    std::vector<LiveProgress> liveProgress(workerCount);
+
+    // What the checkpoints build on: the resumed checkpoint, or an empty run
+    Checkpoint base = resumeFrom;
+    if (!resuming) {
+        base.n = n;
+        base.symmetry = opts.search.symmetry;
+        base.countOnly = opts.search.countOnly;
+        base.format = opts.search.format;
+        base.bySecond.assign(opts.search.countOnly && opts.search.breakdown ? cfg.n : 0, 0);
+    }
+    base.tasks.clear();
 
+    std::optional<Checkpointer> checkpointer;
+    if (!opts.checkpointPath.empty()) {
+        checkpointer.emplace(opts.checkpointPath,
+                             opts.checkpointInterval,
+                             base,
+                             pool,
+                             workerCounts,
+                             sequences_found,
+                             filename ? &*writer : nullptr);
+    }
+
+    std::optional<ProgressReporter> reporter;
+    if (opts.progressInterval > 0.0) {
+        reporter.emplace(opts.progressInterval, liveProgress, 1.0 - remaining, base.sequences, std::cerr);
+    }
+
+    const auto worker = opts.engine == SearchEngine::Pairs ? pair_search_worker : search_worker;
     for (int i = 0; i < workerCount; i++) {
-        workers.emplace_back(search_worker,
+        workers.emplace_back(worker,
                              i,
-                            workerCount,
-                            std::cref(cfg),
-                            std::ref(resultChannel),
-                            std::ref(nodesExpanded));
+                             std::ref(pool),
+                             std::cref(cfg),
+                             std::cref(opts.search),
+                             std::ref(resultChannel),
+                             std::ref(workerCounts[i]),
+                             std::ref(nodesExpanded),
+                             std::ref(liveProgress[i]));
+    }
+
+    if (checkpointer) {
+        checkpointer->start();
+    }
+    if (reporter) {
+        reporter->start();
     }
 
     // Now we need to wait for all workers to finish
     for (auto& t: workers) {
         t.join();
     }
+    if (checkpointer) {
+        checkpointer->stop();
+    }
+    if (reporter) {
+        reporter->stop();
+    }
 
     // Now no more reuslts will be produced
     resultChannel.close();
 
     // Now we need to flush everything and join everything back together.
-    writerThread.join();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    const bool writeFailed = writer && writer->failed();
+    if (reorder && !reorder->error().empty()) {
+        std::cerr << (reorder->complete() ? "Warning: " : "Error: ") << reorder->error() << "." << std::endl;
+    }
+    const double searchSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - searchStart).count();
+    const std::size_t searchAllocations = heap_allocations() - allocationsBefore;
+
+    // Merge the worker-private counters, on top of what a resumed checkpoint had already done
+    SearchCounts total;
+    total.nodes = base.nodes + nodesExpanded.load() + mitmCounts.nodes;
+    total.sequences = base.sequences + mitmCounts.sequences;
+    total.bySecond = base.bySecond;
+    for (std::size_t v = 0; v < mitmCounts.bySecond.size() && v < total.bySecond.size(); v++) {
+        total.bySecond[v] += mitmCounts.bySecond[v];
+    }
+    for (const SearchCounts& c : workerCounts) {
+        total.sequences += c.sequences;
+        for (std::size_t v = 0; v < c.bySecond.size() && v < total.bySecond.size(); v++) {
+            total.bySecond[v] += c.bySecond[v];
+        }
+        total.finalStepPruned += c.finalStepPruned;
+        total.pairCoveragePruned += c.pairCoveragePruned;
+        total.stats.merge(c.stats);
+    }
+    // Workers may have found a few more before they saw the cancellation
+    const bool stoppedAtLimit = opts.limit > 0 && pool.cancelled();
+    if (opts.limit > 0) {
+        total.sequences = std::min(total.sequences, opts.limit);
+    }
 
     // Output 
-    std::cout << "Search complete." << std::endl;
-    std::cout << "Nodes expanded: " << nodesExpanded.load() << std::endl;
-    std::cout << "Valid sequences found: " << sequences_found.load() << std::endl;
-    std::cout << "Results written to: " << filename << std::endl;
+    std::cout << (stoppedAtLimit ? "Search stopped at the limit of " + std::to_string(opts.limit) + " sequences."
+                                 : std::string("Search complete.")) << std::endl;
+    std::cout << "Nodes expanded: " << total.nodes << std::endl;
+    std::cout << "Valid sequences found: " << total.sequences << std::endl;
+    std::cout << "Search time: " << searchSeconds << " s" << std::endl;
+    // Flat in the number of sequences once the result slabs are recycled
+    std::cout << "Heap allocations during the search: " << searchAllocations << std::endl;
+    if (opts.search.lookahead && opts.engine == SearchEngine::Dfs) {
+        std::cout << "Lookahead pruned: " << total.finalStepPruned << " (final step), "
+                  << total.pairCoveragePruned << " (pair coverage)" << std::endl;
+    }
+    if (opts.meetInMiddle) {
+        std::cout << "Meet in the middle: " << mitmStats.partitionsJoined << " partitions joined"
+                  << " (" << mitmStats.leftHalves << " left halves, "
+                  << mitmStats.indexBytes / 1048576.0 << " MiB; "
+                  << mitmStats.rightHalves << " right halves), "
+                  << mitmStats.partitionsFallback << " searched depth-first" << std::endl;
+    }
+    for (std::size_t v = 0; v < total.bySecond.size(); v++) {
+        if (total.bySecond[v] > 0) {
+            std::cout << "  second element " << v << ": " << total.bySecond[v] << std::endl;
+        }
+    }
 
-    return 0;
+    if (checkpointer) {
+        std::cout << "Checkpoints written: " << checkpointer->checkpoints_written()
+                  << " (" << opts.checkpointPath << ")" << std::endl;
+        if (checkpointer->checkpoints_failed() > 0) {
+            std::cerr << "Warning: " << checkpointer->checkpoints_failed() << " checkpoint(s) failed, the last with: "
+                      << checkpointer->last_error() << std::endl;
+        }
+    }
+    if (filename) {
+        if (writeFailed) {
+            std::cerr << "Error: Could not write " << filename << "; the output is incomplete." << std::endl;
+        } else {
+            std::cout << "Results written to: " << filename << std::endl;
+        }
+
+        // Backpressure summary: stalls mean output, not search, was the bottleneck
+        const ChannelStats chStats = resultChannel.stats();
+        std::cout << "Result queue: peak " << chStats.peakQueued << " sequences"
+                  << ", producer stalls " << chStats.stalls
+                  << " (" << chStats.stallSeconds * 1000.0 << " ms)" << std::endl;
+        std::cout << "Result slabs: " << resultChannel.slabs_allocated() << " allocated, "
+                  << kResultBatchSize << " sequences each" << std::endl;
+        if (reorder) {
+            const ReorderStats& roStats = reorder->stats();
+            std::cout << "Reorder buffer: peak " << roStats.peakBytes / 1048576.0 << " MiB"
+                      << ", " << roStats.spilledBytes / 1048576.0 << " MiB spilled"
+                      << ", up to " << roStats.peakPending << " tasks pending" << std::endl;
+        }
+    }
+
+    // Per-worker scheduling summary, to check how evenly the work was spread
+    for (int i = 0; i < workerCount; i++) {
+        const WorkerStats& st = pool.stats(i);
+        const double total = st.busySeconds + st.idleSeconds;
+        std::cout << "Worker " << i
+                  << ": busy " << st.busySeconds * 1000.0 << " ms"
+                  << ", idle " << st.idleSeconds * 1000.0 << " ms"
+                  << ", utilization " << (total > 0.0 ? 100.0 * st.busySeconds / total : 0.0) << "%"
+                  << ", tasks " << st.tasksRun
+                  << " (" << st.tasksStolen << " stolen)" << std::endl;
+    }
+
+    // Per-rule, per-depth counters of an instrumented build
+    print_search_stats(total.stats, std::cout);
+
+    if (opts.shard.count > 0) {
+        ShardManifest manifest;
+        manifest.n = n;
+        manifest.shard = opts.shard;
+        manifest.depth = shardDepth;
+        manifest.symmetry = opts.search.symmetry;
+        manifest.countOnly = opts.search.countOnly;
+        manifest.format = opts.search.format;
+        manifest.output = filename ? filename : "";
+        manifest.sequences = total.sequences;
+        manifest.nodes = total.nodes;
+        manifest.prefixes = std::move(shardPrefixes);
+        std::string error;
+        if (!save_shard_manifest(opts.manifestPath, manifest, error)) {
+            std::cerr << "Error: " << error << "." << std::endl;
+            return 1;
+        }
+        std::cout << "Shard manifest written to: " << opts.manifestPath << std::endl;
+    }
+
+    if (!opts.statsJsonPath.empty()) {
+        RunSummary summary;
+        summary.n = n;
+        summary.symmetry = opts.search.symmetry;
+        summary.seconds = searchSeconds;
+        summary.total = total;
+        summary.workers = workerCounts;
+        for (int i = 0; i < workerCount; i++) {
+            summary.workerStats.push_back(pool.stats(i));
+        }
+        if (!write_stats_json(opts.statsJsonPath, summary)) {
+            std::cerr << "Error: Could not write " << opts.statsJsonPath << "." << std::endl;
+            return 1;
+        }
+        std::cout << "Statistics written to: " << opts.statsJsonPath << std::endl;
+    }
+
+    // A failed write, or an ordered run that lost results from its spill file, leaves an incomplete output file
+    return writeFailed || (reorder && !reorder->complete()) ? 1 : 0;
 }
\ No newline at end of file
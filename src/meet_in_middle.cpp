@@ -0,0 +1,433 @@
+/**
+ * @file src/meet_in_middle.cpp
+ *
+ * @brief Implementation of the meet-in-the-middle search.
+ *
+ * @details Both phases run on workerCount threads that take their partitions from a
+ * WorkStealingPool. The first phase collects the left halves of every partition
+ * that fits, which are then merged into one index sorted by key; the second
+ * enumerates the right halves and looks each one up. The halves are enumerated with the same state types as dfs_search(), so
+ * the specialized kernels and the lookahead apply to them as well.
+ */
+
+#include "meet_in_middle.h"
+#include "search_state.h"
+#include "fixed_search_state.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Left halves a partition reserves against the memory cap at a time.
+ */
+static constexpr std::size_t kReserveHalves = 4096;
+
+/**
+ * @struct HalfKey
+ *
+ * @brief What a left half must match exactly: its middle, its difference pairs and its partner classes.
+ *
+ * @var pairs The difference pairs, bit p for {p, n - p}, shifted left by 6 and or'ed with the middle element.
+ * @var classes The partner classes {x, 1 - x} of a_1..a_m, bit min(x, 1 - x) for each.
+ */
+struct HalfKey {
+    std::uint64_t pairs;
+    std::uint64_t classes;
+
+    bool operator <(const HalfKey& other) const {
+        return pairs != other.pairs ? pairs < other.pairs : classes < other.classes;
+    }
+    bool operator ==(const HalfKey& other) const {
+        return pairs == other.pairs && classes == other.classes;
+    }
+};
+
+/**
+ * @struct HalfEntry
+ *
+ * @brief One left half in the index.
+ *
+ * @var key The half's key.
+ * @var offset Where the half's elements a_1..a_m start in HalfIndex::elements.
+ */
+struct HalfEntry {
+    HalfKey key;
+    std::size_t offset;
+};
+
+/**
+ * @struct HalfIndex
+ *
+ * @brief Left halves and their elements; sorted by key once every partition is in.
+ */
+struct HalfIndex {
+    std::vector<HalfEntry> entries;
+    std::vector<std::uint8_t> elements;
+};
+
+/**
+ * @struct JoinContext
+ *
+ * @brief What the workers of both phases share.
+ *
+ * @details mtx guards the per-worker indexes, fallback, counts and stats while the phases
+ * run; workers only take it for the partitions that do not fit and when they finish.
+ */
+struct JoinContext {
+    const NS1D0Config& cfg;
+    const SearchOptions& opts;
+    int leftLength;                 // a_0..a_m
+    int rightLength;                // a_m..a_{k-1}
+    std::size_t memoryLimit;
+    std::atomic<std::size_t> reserved{0};
+    std::mutex mtx;
+    std::vector<HalfIndex> built;   // phase 1, one per worker
+    HalfIndex index;                // phase 2, all of them merged
+    int partitionsJoined;
+    std::vector<SearchTask> fallback;
+    ResultChannel& resultChannel;
+    SearchCounts& counts;
+    MeetInMiddleStats& stats;
+};
+
+/**
+ * @brief (1 - v) mod n, the Rule 5 partner of v and its image under the mirror map.
+ */
+static int partner_of(int v, int n) {
+    return (n + 1 - v) % n;
+}
+
+/**
+ * @brief The partner class {v, 1 - v} of a value v >= 2, as one bit.
+ */
+static std::uint64_t class_bit(int v, int n) {
+    return std::uint64_t{1} << std::min(v, partner_of(v, n));
+}
+
+/**
+ * @brief The key of a prefix: its last element, difference pairs and the classes of all but its first element.
+ *
+ * @param seq The prefix; a left half, or the mirror image of a right half.
+ * @param n The modulus.
+ *
+ * @return HalfKey The key. A left half is indexed under it as is; a right half looks up its complement.
+ */
+static HalfKey half_key(const std::vector<int>& seq, int n) {
+    std::uint64_t pairs = 0;
+    std::uint64_t classes = 0;
+    for (std::size_t i = 1; i < seq.size(); ++i) {
+        const int diff = (seq[i] - seq[i - 1] + n) % n;
+        pairs |= std::uint64_t{1} << std::min(diff, n - diff);
+        classes |= class_bit(seq[i], n);
+    }
+    return HalfKey{(pairs << 6) | static_cast<std::uint64_t>(seq.back()), classes};
+}
+
+/**
+ * @brief Extend the state's prefix to every valid prefix of the given length and call leaf on each.
+ *
+ * @param state The state holding the prefix to extend.
+ * @param first The first candidate to try for the next position.
+ * @param last One past the last candidate to try for the next position.
+ * @param length The length of the halves.
+ * @param lookahead Skip prefixes that cannot be completed to a whole sequence.
+ * @param nodes Incremented for every prefix pushed.
+ * @param leaf Called with every half; returns false to stop the enumeration.
+ *
+ * @return false If leaf stopped the enumeration.
+ */
+template <typename State, typename Leaf>
+static bool extend_half(State& state, int first, int last, int length, bool lookahead,
+                        std::size_t& nodes, Leaf& leaf) {
+    typename State::Candidates candidates = state.candidates(first);
+    int candidate;
+    while (candidates.next(candidate) && candidate < last) {
+        ++nodes;
+        state.push(candidate);
+        bool more = true;
+        if (lookahead && state.lookahead() != PruneReason::None) {
+            // prune: no whole sequence has this prefix, so no half of one does either
+        } else if (state.size() == length) {
+            more = leaf(state.sequence());
+        } else {
+            more = extend_half(state, 0, state.n(), length, lookahead, nodes, leaf);
+        }
+        state.pop();
+        if (!more) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Run extend_half() on a task's prefix and candidate range.
+ */
+template <typename State, typename Leaf>
+static bool enumerate_task(State& state, const SearchTask& task, int length, bool lookahead,
+                           std::size_t& nodes, Leaf& leaf) {
+    for (int v : task.prefix) {
+        state.push(v);
+    }
+    const bool done = extend_half(state, task.first, task.last, length, lookahead, nodes, leaf);
+    while (state.size() > 0) {
+        state.pop();
+    }
+    return done;
+}
+
+/**
+ * @brief Phase 1 worker: add the left halves of partitions to this worker's index until the pool is empty.
+ *
+ * @param ctx The shared join state.
+ * @param pool The partitions, one task per second element.
+ * @param worker The index of this worker.
+ *
+ * @return void
+ *
+ * @details Memory is reserved against the cap kReserveHalves halves at a time. A partition
+ * that cannot get its next reservation is cut back out of the index and goes to the
+ * depth-first search, so which partitions fit can depend on the order the workers finish
+ * in; the sequences found do not.
+ */
+template <typename State>
+static void build_partitions(JoinContext& ctx, WorkStealingPool& pool, int worker) {
+    const int n = ctx.cfg.n;
+    const std::size_t halfBytes = sizeof(HalfEntry) + static_cast<std::size_t>(ctx.leftLength - 1);
+    HalfIndex& index = ctx.built[worker];
+    State state(ctx.cfg);
+    std::size_t nodes = 0;
+    std::size_t reserved = 0;     // bytes this worker holds against the cap
+    int joined = 0;
+
+    SearchTask task;
+    while (pool.next(worker, task)) {
+        const std::size_t firstEntry = index.entries.size();
+        const std::size_t firstElement = index.elements.size();
+        bool fits = true;
+
+        auto leaf = [&](const std::vector<int>& seq) {
+            if ((index.entries.size() + 1) * halfBytes > reserved) {
+                const std::size_t chunk = kReserveHalves * halfBytes;
+                if (ctx.reserved.fetch_add(chunk, std::memory_order_relaxed) + chunk > ctx.memoryLimit) {
+                    ctx.reserved.fetch_sub(chunk, std::memory_order_relaxed);
+                    fits = false;
+                    return false;
+                }
+                reserved += chunk;
+            }
+            index.entries.push_back(HalfEntry{half_key(seq, n), index.elements.size()});
+            index.elements.insert(index.elements.end(), seq.begin() + 1, seq.end());
+            return true;
+        };
+        enumerate_task(state, task, ctx.leftLength, ctx.opts.lookahead, nodes, leaf);
+
+        if (fits) {
+            ++joined;
+        } else {
+            index.entries.resize(firstEntry);
+            index.elements.resize(firstElement);
+            std::lock_guard<std::mutex> lock(ctx.mtx);
+            ctx.fallback.push_back(task);
+        }
+        pool.task_done();
+    }
+
+    // Hand back what the last reservation did not use
+    const std::size_t used = index.entries.size() * halfBytes;
+    ctx.reserved.fetch_sub(reserved - used, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(ctx.mtx);
+    ctx.counts.nodes += nodes;
+    ctx.partitionsJoined += joined;
+    ctx.stats.leftHalves += index.entries.size();
+    ctx.stats.indexBytes += used;
+}
+
+/**
+ * @brief Merge the workers' indexes into one and sort it by key.
+ *
+ * @param ctx The shared join state.
+ *
+ * @return void
+ */
+static void merge_indexes(JoinContext& ctx) {
+    HalfIndex& index = ctx.index;
+    index = std::move(ctx.built[0]);
+    for (std::size_t w = 1; w < ctx.built.size(); ++w) {
+        HalfIndex& other = ctx.built[w];
+        const std::size_t base = index.elements.size();
+        for (HalfEntry entry : other.entries) {
+            entry.offset += base;
+            index.entries.push_back(entry);
+        }
+        index.elements.insert(index.elements.end(), other.elements.begin(), other.elements.end());
+        other = HalfIndex{};
+    }
+    ctx.built.clear();
+    std::sort(index.entries.begin(), index.entries.end(),
+              [](const HalfEntry& a, const HalfEntry& b) { return a.key < b.key; });
+}
+
+/**
+ * @brief Phase 2 worker: enumerate right halves and join each with the matching left halves.
+ *
+ * @param ctx The shared join state; the index is read-only by now.
+ * @param pool The right halves to enumerate, as mirrored prefixes.
+ * @param worker The index of this worker.
+ *
+ * @return void
+ *
+ * @details A right half is enumerated as its mirror image r_0..r_j, a prefix starting at 0.
+ * The half itself is (1 - r_j, ..., 1 - r_0): it meets the left half at 1 - r_j, keeps the
+ * difference pairs of its mirror and covers the same partner classes. A sequence uses every
+ * difference pair once (Rule 6) and, besides 0 and 1, exactly one value of every partner
+ * class (uniqueness and Rule 5; there are as many classes as free positions). So the left
+ * halves that fit are exactly those that end at 1 - r_j, use the complementary pairs and
+ * share no class but the middle one, and every index entry under that key is a sequence.
+ */
+template <typename State>
+static void join_halves(JoinContext& ctx, WorkStealingPool& pool, int worker) {
+    const int n = ctx.cfg.n;
+    std::uint64_t allPairs = 0;
+    std::uint64_t allClasses = 0;
+    for (int v = 2; v < n; ++v) {
+        if (v <= n / 2) allPairs |= std::uint64_t{1} << v;
+        if (v != ctx.cfg.forbidden) allClasses |= class_bit(v, n);
+    }
+    allPairs |= std::uint64_t{1} << 1;
+    const HalfIndex& index = ctx.index;
+    const std::size_t leftElements = static_cast<std::size_t>(ctx.leftLength - 1);
+    State state(ctx.cfg);
+
+    SearchCounts counts;
+    if (ctx.opts.countOnly && ctx.opts.breakdown) {
+        counts.bySecond.assign(n, 0);
+    }
+    std::size_t rightHalves = 0;
+    ResultBatcher results(ctx.resultChannel, ctx.opts.format, n, ctx.cfg.targetLength);
+    std::vector<int> joined(ctx.cfg.targetLength);
+
+    auto leaf = [&](const std::vector<int>& mirror) {
+        ++rightHalves;
+        const HalfKey own = half_key(mirror, n);
+        const int middle = partner_of(mirror.back(), n);
+        const HalfKey key{((allPairs & ~(own.pairs >> 6)) << 6) | static_cast<std::uint64_t>(middle),
+                          (allClasses & ~own.classes) | class_bit(middle, n)};
+
+        auto it = std::lower_bound(index.entries.begin(), index.entries.end(), key,
+                                   [](const HalfEntry& e, const HalfKey& k) { return e.key < k; });
+        for (; it != index.entries.end() && it->key == key; ++it) {
+            ++counts.sequences;
+            if (ctx.opts.countOnly) {
+                if (!counts.bySecond.empty()) {
+                    ++counts.bySecond[index.elements[it->offset]];
+                }
+                continue;
+            }
+            joined[0] = 0;
+            for (std::size_t i = 0; i < leftElements; ++i) {
+                joined[i + 1] = index.elements[it->offset + i];
+            }
+            for (std::size_t i = 1; i < mirror.size(); ++i) {
+                joined[leftElements + i] = partner_of(mirror[mirror.size() - 1 - i], n);
+            }
+            results.add(joined.data());
+        }
+        return true;
+    };
+
+    SearchTask task;
+    while (pool.next(worker, task)) {
+        enumerate_task(state, task, ctx.rightLength, ctx.opts.lookahead, counts.nodes, leaf);
+        results.flush();
+        pool.task_done();
+    }
+
+    std::lock_guard<std::mutex> lock(ctx.mtx);
+    ctx.counts.nodes += counts.nodes;
+    ctx.counts.sequences += counts.sequences;
+    for (std::size_t v = 0; v < counts.bySecond.size() && v < ctx.counts.bySecond.size(); ++v) {
+        ctx.counts.bySecond[v] += counts.bySecond[v];
+    }
+    ctx.stats.rightHalves += rightHalves;
+}
+
+/**
+ * @brief Run one phase on workerCount threads, each taking tasks from a fresh pool.
+ */
+template <typename Phase>
+static void run_phase(const std::vector<SearchTask>& tasks, int workerCount, Phase phase) {
+    WorkStealingPool pool(workerCount);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        pool.push(static_cast<int>(i % workerCount), tasks[i]);
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount);
+    for (int w = 0; w < workerCount; ++w) {
+        threads.emplace_back([&pool, &phase, w] { phase(pool, w); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Find every sequence of the partitions whose halves fit in memory by joining halves.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param opts Search options; symmetry is ignored.
+ * @param memoryLimit Bytes the index of left halves may use.
+ * @param workerCount Number of threads to build the index and run the join with.
+ * @param resultChannel Channel to send batches of the sequences found; unused in count-only mode.
+ * @param counts Receives the nodes of both half searches and the sequences found.
+ * @param stats Receives what the engine did.
+ *
+ * @return std::vector<SearchTask> The partitions left to the depth-first search, which must
+ * search them with symmetry breaking off.
+ *
+ * @details The cut is at m = (k - 1) / 2, so the indexed left halves are never longer than the
+ * streamed right halves. Sequences shorter than 4 have no middle worth joining at, and n above
+ * kMaxMeetInMiddleN does not fit the masks; both leave every partition to the depth-first search.
+ */
+std::vector<SearchTask> meet_in_middle_search(const NS1D0Config& cfg,
+                                              const SearchOptions& opts,
+                                              std::size_t memoryLimit,
+                                              int workerCount,
+                                              ResultChannel& resultChannel,
+                                              SearchCounts& counts,
+                                              MeetInMiddleStats& stats) {
+    const std::vector<SearchTask> partitions = initial_search_tasks(cfg);
+    if (opts.countOnly && opts.breakdown) {
+        counts.bySecond.assign(cfg.n, 0);
+    }
+    if (cfg.n > kMaxMeetInMiddleN || cfg.targetLength < 4) {
+        stats.partitionsFallback = static_cast<int>(partitions.size());
+        return partitions;
+    }
+
+    const int middle = (cfg.targetLength - 1) / 2;
+    JoinContext ctx{cfg, opts, middle + 1, cfg.targetLength - middle, memoryLimit,
+                    {}, {}, std::vector<HalfIndex>(workerCount), {}, 0, {}, resultChannel, counts, stats};
+
+    with_search_state(cfg.n, opts.specialized, [&](auto tag) {
+        using State = typename decltype(tag)::type;
+        run_phase(partitions, workerCount, [&](WorkStealingPool& pool, int w) {
+            build_partitions<State>(ctx, pool, w);
+        });
+        merge_indexes(ctx);
+        if (ctx.partitionsJoined > 0) {
+            run_phase(initial_search_tasks(cfg), workerCount, [&](WorkStealingPool& pool, int w) {
+                join_halves<State>(ctx, pool, w);
+            });
+        }
+    });
+
+    std::sort(ctx.fallback.begin(), ctx.fallback.end(),
+              [](const SearchTask& a, const SearchTask& b) { return a.first < b.first; });
+    stats.partitionsJoined = ctx.partitionsJoined;
+    stats.partitionsFallback = static_cast<int>(ctx.fallback.size());
+    return ctx.fallback;
+}
@@ -10,8 +10,16 @@
  */
 
 #include "ns1d0.h"
+#include "search_state.h"
+#include "fixed_search_state.h"
+#include "reorder.h"
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <utility>
 #include <vector>
 
 /**
@@ -42,8 +50,8 @@ static int mod(int a, int n) {
  * @details This function checks if the length of the sequence does not exceed the target length
  * specified in the configuration.
  */
-static bool rule1_length(const std::vector<int>& seq,
-                         const NS1D0Config& cfg) {
+bool rule1_length(const std::vector<int>& seq,
+                  const NS1D0Config& cfg) {
     if (seq.empty()) {
         return false;
     }
@@ -64,8 +72,8 @@ static bool rule1_length(const std::vector<int>& seq,
  * 
  * @details This function checks that all integers in the sequence are unique and fall within the specified range [0, n-1]. 
  */
-static bool rule_unique_and_in_range(const std::vector<int>& seq,
-                                     const NS1D0Config& cfg) {
+bool rule_unique_and_in_range(const std::vector<int>& seq,
+                              const NS1D0Config& cfg) {
     const int n = cfg.n;
     std::vector<bool> seen(n, false);
 
@@ -86,7 +94,7 @@ static bool rule_unique_and_in_range(const std::vector<int>& seq,
  * 
  * @details This function checks if the first element of the sequence is zero.
  */
-static bool rule2_starts_with_zero(const std::vector<int>& seq) {
+bool rule2_starts_with_zero(const std::vector<int>& seq) {
     return !seq.empty() && seq[0] == 0;
 };
 
@@ -102,7 +110,7 @@ static bool rule2_starts_with_zero(const std::vector<int>& seq) {
  * @details For complete sequences, the last element must be 1.
  * For prefixes, the sequence must not contain 1 before the last position to ensure it can be placed at the end later.
  */
-static bool rule3_one_at_end(const std::vector<int>& seq, const NS1D0Config& cfg) {
+bool rule3_one_at_end(const std::vector<int>& seq, const NS1D0Config& cfg) {
     if (static_cast<int>(seq.size()) == cfg.targetLength) {
         return !seq.empty() && seq.back() == 1;
     } else {
@@ -124,7 +132,7 @@ static bool rule3_one_at_end(const std::vector<int>& seq, const NS1D0Config& cfg
  * 
  * @details This function checks if the sequence contains the forbidden value specified in the configuration.
  */
-static bool rule4_no_forbidden(const std::vector<int>& seq, const NS1D0Config& cfg) {
+bool rule4_no_forbidden(const std::vector<int>& seq, const NS1D0Config& cfg) {
     for (int v : seq) {
         if (v == cfg.forbidden) return false;
     }
@@ -141,7 +149,7 @@ static bool rule4_no_forbidden(const std::vector<int>& seq, const NS1D0Config& c
  * 
  * @details For any 1 < x < n, the sequence can have either x or (1 - x) mod n, but not both.
  */
-static bool rule5_pair_exclusion(const std::vector<int>& seq, const NS1D0Config& cfg) {
+bool rule5_pair_exclusion(const std::vector<int>& seq, const NS1D0Config& cfg) {
     const int n = cfg.n;
     std::vector<bool> present(n, false);
 
@@ -170,7 +178,7 @@ static bool rule5_pair_exclusion(const std::vector<int>& seq, const NS1D0Config&
  * For each j = 1..n-1, only one of {j, -j mod n} may appear as a difference,
  * and each such pair may appear at most once.
  */
-static bool rule6_differences_unique_pairs(const std::vector<int>& seq, const NS1D0Config& cfg) {
+bool rule6_differences_unique_pairs(const std::vector<int>& seq, const NS1D0Config& cfg) {
     const int n = cfg.n;
     std::vector<bool> usedPair(n, false); // only indices 1..(n-1)/2 will be used
 
@@ -216,137 +224,725 @@ bool is_valid_prefix(const std::vector<int>& seq, const NS1D0Config& cfg) {
 
 
 /**
- * @brief Check whether a *complete* sequence is valid.
+ * @brief Minimum number of positions left to fill before a subtree is worth handing to another worker.
+ */
+static constexpr int kMinSplitRemaining = 3;
+
+/**
+ * @brief Workers publish their live progress whenever their node count is a multiple of this mask plus one.
+ */
+static constexpr std::size_t kProgressMask = (std::size_t{1} << 14) - 1;
+
+/**
+ * @struct WorkerContext
  * 
- * @param seq The sequence of integers to check.
- * @param cfg Configuration containing the target length and other parameters.
+ * @brief Everything one worker needs while running search tasks.
+ * 
+ * @details cursor[d] is the candidate currently explored for position d and last[d] is one past the
+ * last candidate this worker still owns for that position. Lowering last[d] is how a worker gives
+ * the rest of a level away to another worker.
+ *
+ * @tparam State SearchState, or the FixedSearchState specialized for the run's n.
+ */
+template <typename State>
+struct WorkerContext {
+    int worker;
+    WorkStealingPool& pool;
+    ResultBatcher results;        // encodes and publishes the results
+    State state;
+    std::vector<int> cursor;
+    std::vector<int> last;
+    int baseDepth;                // first position owned by the running task
+    bool symmetry;                // only explore canonical sequences, emit mirrors
+    bool lookahead;               // prune prefixes that cannot be completed
+    std::vector<int> mirror;      // scratch buffer for the mirrored sequence
+    bool countOnly;               // count sequences instead of publishing them
+    const ResultCallback* onResult;   // receives results in place of the channel, if set
+    SearchCounts counts;          // this worker's counters
+    SearchCounts& report;         // where the counters are handed back to main
+    LiveProgress& live;           // where the progress reporter reads the counters
+    int job;                      // job of the tasks this context runs, copied into every split
+    std::atomic<std::size_t>* jobPending;   // the job's unfinished tasks in a sweep; null otherwise
+};
+
+/**
+ * @brief Record the current (complete) sequence, and its mirror when searching canonical sequences only.
+ * 
+ * @param ctx The worker's search context.
+ * 
+ * @return void
+ */
+template <typename State>
+static void emit_result(WorkerContext<State>& ctx) {
+    ctx.counts.sequences += ctx.symmetry ? 2 : 1;
+    if (ctx.onResult) {
+        // Zero copy: the callback sees the worker's own buffers
+        const std::vector<int>& seq = ctx.state.sequence();
+        if (!ctx.pool.cancelled() && !(*ctx.onResult)(seq.data(), seq.size())) {
+            ctx.pool.cancel();
+        }
+        if (ctx.symmetry && !ctx.pool.cancelled()) {
+            ctx.state.mirror(ctx.mirror);
+            if (!(*ctx.onResult)(ctx.mirror.data(), ctx.mirror.size())) {
+                ctx.pool.cancel();
+            }
+        }
+        return;
+    }
+
+    if (ctx.countOnly) {
+        const std::vector<int>& seq = ctx.state.sequence();
+        if (!ctx.counts.bySecond.empty()) {
+            ++ctx.counts.bySecond[seq[1]];
+            if (ctx.symmetry) {
+                // The mirror's second element is (1 - a_{k-2}) mod n
+                const int n = ctx.state.config().n;
+                ++ctx.counts.bySecond[(n + 1 - seq[seq.size() - 2]) % n];
+            }
+        }
+        return;
+    }
+
+    ctx.results.add(ctx.state.sequence().data());
+    if (ctx.symmetry) {
+        ctx.state.mirror(ctx.mirror);
+        ctx.results.add(ctx.mirror.data());
+    }
+}
+
+/**
+ * @brief Hand the shallowest unexplored part of this worker's tree to the pool.
+ * 
+ * @param ctx The worker's search context.
+ * 
+ * @return void
+ * 
+ * @details Walks the positions owned by the running task from the top down and queues the
+ * remaining candidates of the first position that still has any as a single task. The worker
+ * then stops its own loop at that position after the current candidate.
+ */
+template <typename State>
+static void split_shallowest(WorkerContext<State>& ctx) {
+    const std::vector<int>& seq = ctx.state.sequence();
+
+    for (int d = ctx.baseDepth; d < ctx.state.size(); ++d) {
+        if (ctx.state.length() - d < kMinSplitRemaining) {
+            return; // everything below is too small to be worth moving
+        }
+        if (ctx.cursor[d] + 1 < ctx.last[d]) {
+            SearchTask task;
+            task.prefix.assign(seq.begin(), seq.begin() + d);
+            task.first = ctx.cursor[d] + 1;
+            task.last = ctx.last[d];
+            task.job = ctx.job;
+            ctx.last[d] = ctx.cursor[d] + 1;
+            if (ctx.jobPending) {
+                // Counted before it can be taken, so the job cannot look finished in between
+                ctx.jobPending->fetch_add(1);
+            }
+            ctx.results.announce(task);
+            ctx.pool.push(ctx.worker, std::move(task));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Publish the worker's counters for the progress reporter.
+ * 
+ * @param ctx The worker's search context.
+ * 
+ * @return void
+ */
+template <typename State>
+static void publish_progress(WorkerContext<State>& ctx) {
+    ctx.live.nodes.store(ctx.counts.nodes, std::memory_order_relaxed);
+    ctx.live.sequences.store(ctx.counts.sequences, std::memory_order_relaxed);
+    ctx.live.explored.store(ctx.counts.explored, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Hand the worker's counters back to main.
  * 
- * @return true If the sequence is complete and valid according to all rules.
+ * @param ctx The worker's search context.
  * 
- * @details This function checks if the given sequence is complete and satisfies all the rules defined in the configuration.
+ * @return void
+ * 
+ * @details Called between tasks and before parking, i.e. only while main may not be reading them.
  */
-static bool is_complete_valid_sequence(const std::vector<int>& seq,
-                                       const NS1D0Config& cfg) {
-    if (static_cast<int>(seq.size()) != cfg.targetLength) {
+template <typename State>
+static void report_counts(WorkerContext<State>& ctx) {
+    ctx.report = ctx.counts;
+    publish_progress(ctx);
+}
+
+/**
+ * @brief Park the worker for a checkpoint, describing its unexplored work as tasks.
+ * 
+ * @param ctx The worker's search context.
+ * @param first The first candidate the current node has not tried yet.
+ * 
+ * @return void
+ * 
+ * @details Called on entry to a node, so the node itself is already counted and none of its
+ * children are. What is left is the rest of this node plus, for every position the running task
+ * owns above it, the candidates after the one being explored. Results found so far are published
+ * first, so the checkpoint's output offset covers exactly the explored part of the tree.
+ */
+template <typename State>
+static void park_worker(WorkerContext<State>& ctx, int first) {
+    const std::vector<int>& seq = ctx.state.sequence();
+    const int depth = ctx.state.size();
+
+    std::vector<SearchTask> frontier;
+    for (int d = ctx.baseDepth; d < depth; ++d) {
+        if (ctx.cursor[d] + 1 < ctx.last[d]) {
+            frontier.push_back(SearchTask{std::vector<int>(seq.begin(), seq.begin() + d),
+                                          ctx.cursor[d] + 1, ctx.last[d], ctx.job});
+        }
+    }
+    if (first < ctx.last[depth]) {
+        frontier.push_back(SearchTask{seq, first, ctx.last[depth], ctx.job});
+    }
+
+    ctx.results.flush();
+    report_counts(ctx);
+    ctx.pool.park(std::move(frontier));
+}
+
+/**
+ * @brief Run the lookahead on the prefix just pushed and count what it cuts.
+ * 
+ * @param ctx The worker's search context.
+ * @param depth The position of the element just pushed.
+ * 
+ * @return true If the prefix cannot be completed.
+ */
+template <typename State>
+static bool lookahead_prunes(WorkerContext<State>& ctx, int depth) {
+    const PruneReason why = ctx.state.lookahead();
+    if (why == PruneReason::None) {
         return false;
     }
-    return is_valid_prefix(seq, cfg);
+    if (why == PruneReason::FinalStep) {
+        ++ctx.counts.finalStepPruned;
+    } else {
+        ++ctx.counts.pairCoveragePruned;
+    }
+    ctx.counts.stats.prune(why, depth);
+    return true;
+}
+
+/**
+ * @brief Count, per rule, the candidates of the current node that candidates() leaves out.
+ * 
+ * @param ctx The worker's search context.
+ * @param first The first candidate the node tries.
+ * 
+ * @return void
+ * 
+ * @details Only called in builds with NS1D0_STATS; the search itself never looks at invalid candidates.
+ */
+template <typename State>
+static void record_pruning(WorkerContext<State>& ctx, int first) {
+    const int depth = ctx.state.size();
+    for (int v = first; v < ctx.last[depth]; ++v) {
+        const PruneReason why = ctx.state.check(v);
+        if (why != PruneReason::None) {
+            ctx.counts.stats.prune(why, depth);
+        }
+    }
 }
 
 /**
  * @brief Perform a depth-first search to find valid sequences.
  * 
- * @param currentSeq The current sequence being constructed.
- * @param cfg Configuration containing the target length and other parameters.
- * @param resultChannel Channel to send valid sequences found.
- * @param nodesExpanded Atomic counter for the number of nodes expanded during the search.
+ * @param ctx The worker's search context, holding the current prefix and its constraint state.
+ * @param first The first candidate to try for the next position.
+ * @param share The share of the whole tree each candidate for the next position stands for.
  * 
  * @return void
  * 
  * @details This function performs a depth-first search to find all valid sequences according to the rules defined in the configuration.
+ * The valid children of a node are built as one bitmask by the state (see SearchState::candidates()),
+ * so invalid children are never visited and the prefix never has to be re-validated. Only valid
+ * children count as expanded nodes. Candidates are tried up to ctx.last for the position, which
+ * other workers may lower at any time through split_shallowest(). With symmetry breaking on, only
+ * the canonical member of each mirror pair is searched (see SearchState::canonical_possible()), and
+ * with lookahead on, prefixes that cannot be completed are not descended into (see
+ * SearchState::lookahead()).
+ * With a FixedSearchState, n and the length are compile-time constants, so the bounds and the
+ * rule checks below are specialized for that n.
+ *
+ * For progress estimates every node splits its share of the tree evenly over its n candidates.
+ * Candidates in [first, last) that are not descended into count as explored once the loop is
+ * done; the others are counted by the recursive calls.
  */
-static void dfs_search(std::vector<int>& currentSeq,
-                       const NS1D0Config& cfg,
-                       Channel<std::vector<int>>& resultChannel,
-                       std::atomic<std::size_t>& nodesExpanded) {
+template <typename State>
+static void dfs_search(WorkerContext<State>& ctx, int first, double share) {
+    State& state = ctx.state;
+    const int depth = state.size();
+
+    // A checkpoint is being taken: stop here until it is written
+    if (ctx.pool.pause_requested()) {
+        park_worker(ctx, first);
+    }
 
-    nodesExpanded.fetch_add(1, std::memory_order_relaxed);
+    // The search was cancelled: abandon the task
+    if (ctx.pool.cancelled()) {
+        return;
+    }
 
-    if (!is_valid_prefix(currentSeq, cfg)) {
-        return; // prune
+    // Somebody is idle and we have nothing queued for them to steal: give work away
+    if (ctx.pool.hungry() && ctx.pool.queued(ctx.worker) == 0) {
+        split_shallowest(ctx);
     }
 
-    if (is_complete_valid_sequence(currentSeq, cfg)) {
-        resultChannel.push(currentSeq);
-        return;
+    // An instrumented build attributes every rejected candidate to the rule that rejects it
+    if constexpr (SearchStats::enabled) {
+        record_pruning(ctx, first);
     }
 
-    // Still need more elements; try all candidates 0..n-1
-    for (int candidate = 0; candidate < cfg.n; ++candidate) {
-        // Enforce "1 only at the very end" here as well (extra safety)
-        if (candidate == 1 &&
-            static_cast<int>(currentSeq.size()) < cfg.targetLength - 1) {
-            continue;
+    typename State::Candidates candidates = state.candidates(first);
+    int candidate;
+    int descended = 0;
+    while (candidates.next(candidate) && candidate < ctx.last[depth]) {
+        ++ctx.counts.nodes;
+        ctx.counts.stats.visit(depth);
+        if ((ctx.counts.nodes & kProgressMask) == 0) {
+            publish_progress(ctx);
         }
 
-        // Uniqueness + range + other rules will be enforced by is_valid_prefix,
-        // but skipping obvious duplicates early is a cheap optimization
-        if (std::find(currentSeq.begin(), currentSeq.end(), candidate) != currentSeq.end()) {
+        ctx.cursor[depth] = candidate;
+        state.push(candidate);
+        if (state.complete()) {
+            emit_result(ctx);
+        } else if (ctx.symmetry && !state.canonical_possible()) {
+            // prune: only the mirror of anything below here is canonical
+            ctx.counts.stats.prune(PruneReason::Symmetry, depth);
+        } else if (ctx.lookahead && lookahead_prunes(ctx, depth)) {
+            // prune: this prefix cannot be completed
+        } else {
+            ctx.last[depth + 1] = state.n();
+            ++descended;
+            dfs_search(ctx, 0, share / state.n());
+        }
+        state.pop();
+    }
+    ctx.counts.explored += share * std::max(0, ctx.last[depth] - first - descended);
+}
+
+/**
+ * @brief The number of worker threads to run.
+ * 
+ * @param requested The number asked for; 0 to pick one.
+ * 
+ * @return int requested if given, otherwise one per hardware thread (4 if that is unknown), and at least 2.
+ */
+int worker_count(int requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    unsigned int hw = std::thread::hardware_concurrency();
+    int workerCount = (hw == 0 ? 4 : static_cast<int>(hw));
+    if (workerCount < 2) workerCount = 2; // min required for homework 2 threads.
+    return workerCount;
+}
+
+/**
+ * @brief The initial search tasks, one per possible second element.
+ * 
+ * @param cfg Configuration containing the target length and other parameters.
+ * 
+ * @return std::vector<SearchTask> The tasks that together cover the whole search tree.
+ * 
+ * @details The first element is always 0 (Rule 2), so the roots are the prefixes {0, v}. They are
+ * dealt round-robin to start with; stealing and splitting balance the load from there.
+ */
+std::vector<SearchTask> initial_search_tasks(const NS1D0Config& cfg) {
+    std::vector<SearchTask> tasks;
+    for (int v = 0; v < cfg.n; ++v) {
+        if (v == 0) continue;             // already at position 0
+        if (v == cfg.forbidden) continue; // Rule 4
+        if (v == 1 && cfg.targetLength > 2) {
+            // Don't place 1 too early
             continue;
         }
+        tasks.push_back(SearchTask{{0}, v, v + 1});
+    }
+    return tasks;
+}
+
+/**
+ * @brief The share of the search tree a task covers, weighting every candidate of a node equally.
+ * 
+ * @param task The task.
+ * @param cfg Configuration containing the target length and other parameters.
+ * 
+ * @return double The task's fraction of the tree; the fractions of disjoint tasks add up.
+ * 
+ * @details The root {0} is the whole tree and each of its n candidates gets 1/n of it, so a
+ * candidate after a prefix of length L stands for n^-L. This is the weighting dfs_search() uses.
+ */
+double task_weight(const SearchTask& task, const NS1D0Config& cfg) {
+    const double share = std::pow(1.0 / cfg.n, static_cast<double>(task.prefix.size()));
+    return share * std::max(0, task.last - task.first);
+}
 
-        currentSeq.push_back(candidate);
-        dfs_search(currentSeq, cfg, resultChannel, nodesExpanded);
-        currentSeq.pop_back();
+/**
+ * @brief Build a worker's search context.
+ * 
+ * @tparam State SearchState, or the FixedSearchState specialized for cfg.n.
+ * 
+ * @details See search_worker() for the parameters; job and jobPending go into the
+ * context for splitting (see sweep_worker()).
+ */
+template <typename State>
+static WorkerContext<State> make_context(int workerIndex,
+                                         WorkStealingPool& pool,
+                                         const NS1D0Config& cfg,
+                                         const SearchOptions& opts,
+                                         ResultChannel& resultChannel,
+                                         SearchCounts& counts,
+                                         LiveProgress& live,
+                                         int job,
+                                         std::atomic<std::size_t>* jobPending) {
+    WorkerContext<State> ctx{workerIndex,
+                             pool,
+                             ResultBatcher(resultChannel, opts.format, cfg.n, cfg.targetLength,
+                                           opts.ordered && !opts.countOnly, opts.resultBatch),
+                             State(cfg),
+                             std::vector<int>(cfg.targetLength + 1, 0),
+                             std::vector<int>(cfg.targetLength + 1, 0),
+                             0,
+                             // Sequences of length 2 are their own mirror
+                             opts.symmetry && cfg.targetLength > 2,
+                             opts.lookahead,
+                             {},
+                             opts.countOnly,
+                             opts.onResult ? &opts.onResult : nullptr,
+                             {},
+                             counts,
+                             live,
+                             job,
+                             jobPending};
+    if (opts.countOnly && opts.breakdown) {
+        ctx.counts.bySecond.assign(cfg.n, 0);
     }
+    ctx.counts.stats.resize(cfg.targetLength);
+    return ctx;
+}
+
+/**
+ * @brief Run one task to the end and hand the counters back.
+ * 
+ * @param ctx The worker's search context, with an empty prefix.
+ * @param task The task.
+ * 
+ * @return void
+ */
+template <typename State>
+static void run_task(WorkerContext<State>& ctx, const SearchTask& task) {
+    // Prefixes come from valid states, so they can be replayed without checks
+    for (int v : task.prefix) {
+        ctx.state.push(v);
+    }
+    ctx.baseDepth = ctx.state.size();
+    ctx.last[ctx.baseDepth] = task.last;
+    ctx.results.begin_task(task);
+
+    dfs_search(ctx, task.first, std::pow(1.0 / ctx.state.n(), static_cast<double>(task.prefix.size())));
+    ctx.results.end_task();
+
+    while (ctx.state.size() > 0) {
+        ctx.state.pop();
+    }
+    report_counts(ctx);
+}
+
+/**
+ * @brief Run search tasks until the pool is exhausted, with the given state type.
+ * 
+ * @tparam State SearchState, or the FixedSearchState specialized for cfg.n.
+ * 
+ * @details See search_worker() for the parameters.
+ */
+template <typename State>
+static void run_worker(int workerIndex,
+                       WorkStealingPool& pool,
+                       const NS1D0Config& cfg,
+                       const SearchOptions& opts,
+                       ResultChannel& resultChannel,
+                       SearchCounts& counts,
+                       std::atomic<std::size_t>& nodesExpanded,
+                       LiveProgress& live) {
+    using Clock = std::chrono::steady_clock;
+
+    WorkerContext<State> ctx = make_context<State>(workerIndex, pool, cfg, opts, resultChannel,
+                                                   counts, live, 0, nullptr);
+
+    SearchTask task;
+    while (pool.next(workerIndex, task)) {
+        const auto start = Clock::now();
+        run_task(ctx, task);
+        pool.task_done();
+        pool.add_busy_time(workerIndex,
+                           std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    nodesExpanded.fetch_add(ctx.counts.nodes, std::memory_order_relaxed);
+    report_counts(ctx);
 }
 
 /**
  * @brief Worker function for searching valid sequences.
  * 
  * @param workerIndex The index of this worker thread.
- * @param workerCount The total number of worker threads.
+ * @param pool The pool to take search tasks from.
  * @param cfg Configuration containing the target length and other parameters.
- * @param resultChannel Channel to send valid sequences found.  
+ * @param opts Search options.
+ * @param resultChannel Channel to send the valid sequences found, encoded in opts.format; unused in count-only mode.
+ * @param counts Receives this worker's counters after every task, at checkpoints and at the end.
  * @param nodesExpanded Atomic counter for the number of nodes expanded during the search.
+ * @param live Where this worker publishes its progress while the search runs.
  * 
  * @return void
  * 
  * @details This function is executed by each worker thread to search for valid sequences. 
+ * It runs tasks from the pool until the whole search tree has been explored. Results are
+ * published in batches, and whatever is left is published at the end of each task. In
+ * count-only mode results are only counted in worker-private counters. The search runs
+ * on the state specialized for cfg.n when there is one and opts.specialized is set.
  */
 void search_worker(int workerIndex,
-                   int workerCount,
+                   WorkStealingPool& pool,
                    const NS1D0Config& cfg,
-                   Channel<std::vector<int>>& resultChannel,
-                   std::atomic<std::size_t>& nodesExpanded) {
-    std::vector<int> secondCandidates;
+                   const SearchOptions& opts,
+                   ResultChannel& resultChannel,
+                   SearchCounts& counts,
+                   std::atomic<std::size_t>& nodesExpanded,
+                   LiveProgress& live) {
+    with_search_state(cfg.n, opts.specialized, [&](auto tag) {
+        using State = typename decltype(tag)::type;
+        run_worker<State>(workerIndex, pool, cfg, opts, resultChannel, counts, nodesExpanded, live);
+    });
+}
 
-    for (int v = 0; v < cfg.n; ++v) {
-        if (v == 0) continue;             // already at position 0
-        if (v == cfg.forbidden) continue; // Rule 4
-        if (v == 1 && cfg.targetLength > 2) {
-            // Don't place 1 too early
-            continue;
+/**
+ * @class JobRunner
+ * 
+ * @brief A sweep worker's context for one job, behind the job's state type.
+ */
+class JobRunner {
+    public:
+        virtual ~JobRunner() = default;
+
+        // Run one of the job's tasks.
+        virtual void run(const SearchTask& task) = 0;
+
+        // Nodes expanded so far.
+        virtual std::size_t nodes() const = 0;
+};
+
+template <typename State>
+class StateJobRunner : public JobRunner {
+    public:
+        StateJobRunner(int workerIndex, WorkStealingPool& pool, SearchJob& job, int jobIndex)
+            : ctx_(make_context<State>(workerIndex, pool, job.cfg, job.opts, *job.channel,
+                                       job.counts[workerIndex], job.live[workerIndex],
+                                       jobIndex, &job.pending)) {}
+
+        void run(const SearchTask& task) override { run_task(ctx_, task); }
+        std::size_t nodes() const override { return ctx_.counts.nodes; }
+
+    private:
+        WorkerContext<State> ctx_;
+};
+
+/**
+ * @brief Worker function for a sweep: runs the tasks of several searches from one shared pool.
+ * 
+ * @param workerIndex The index of this worker thread.
+ * @param pool The pool to take search tasks from; SearchTask::job indexes jobs.
+ * @param jobs The searches; each needs counts and live sized for the pool's workers.
+ * 
+ * @return void
+ * 
+ * @details Contexts are made on a job's first task, so a worker that never sees a job
+ * does not pay for it. Splitting and stealing work across jobs as they do within one:
+ * a worker that runs dry takes whatever task is oldest, from any n.
+ */
+void sweep_worker(int workerIndex, WorkStealingPool& pool, std::deque<SearchJob>& jobs) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::unique_ptr<JobRunner>> runners(jobs.size());
+
+    SearchTask task;
+    while (pool.next(workerIndex, task)) {
+        const auto start = Clock::now();
+        SearchJob& job = jobs[task.job];
+        std::unique_ptr<JobRunner>& runner = runners[task.job];
+        if (!runner) {
+            with_search_state(job.cfg.n, job.opts.specialized, [&](auto tag) {
+                using State = typename decltype(tag)::type;
+                runner = std::make_unique<StateJobRunner<State>>(workerIndex, pool, job, task.job);
+            });
+        }
+        runner->run(task);
+
+        if (job.pending.fetch_sub(1) == 1) {
+            // That was the job's last task: its results are all published
+            job.finished = Clock::now();
+            job.channel->close();
         }
-        secondCandidates.push_back(v);
+        pool.task_done();
+        pool.add_busy_time(workerIndex,
+                           std::chrono::duration<double>(Clock::now() - start).count());
     }
 
-    for (std::size_t i = 0; i < secondCandidates.size(); ++i) {
-        if (static_cast<int>(i % workerCount) != workerIndex) continue;
+    for (std::size_t j = 0; j < runners.size(); ++j) {
+        if (runners[j]) {
+            jobs[j].nodes.fetch_add(runners[j]->nodes(), std::memory_order_relaxed);
+        }
+    }
+}
 
-        std::vector<int> seq;
-        seq.reserve(cfg.targetLength);
-        seq.push_back(0);                  // Rule 2
-        seq.push_back(secondCandidates[i]);
+/**
+ * @brief Set up a batcher with a slab pool of its own.
+ * 
+ * @param channel The channel to publish to, which also owns the pool.
+ * @param format The output format to encode in.
+ * @param n The modulus of the sequences.
+ * @param length The number of elements in every sequence.
+ * @param ordered Whether to tag the slabs for ordered output.
+ * @param batch Sequences per slab published; clamped to [1, kResultBatchSize].
+ */
+ResultBatcher::ResultBatcher(ResultChannel& channel, SeqFormat format, int n, int length, bool ordered,
+                             std::size_t batch)
+    : channel_(channel),
+      pool_(channel.new_pool(SeqEncoder(format, n, length).max_bytes())),
+      encoder_(format, n, length),
+      ordered_(ordered),
+      batch_(std::clamp<std::size_t>(batch, 1, kResultBatchSize)),
+      slab_(pool_.acquire()) {
+    if (ordered_) {
+        taskKey_.reserve(static_cast<std::size_t>(length) + 1);
+    }
+}
 
-        dfs_search(seq, cfg, resultChannel, nodesExpanded);
+/**
+ * @brief Start tagging results with a task's order key.
+ * 
+ * @param task The task about to run.
+ * 
+ * @return void
+ */
+void ResultBatcher::begin_task(const SearchTask& task) {
+    if (ordered_) {
+        assign_order_key(task, taskKey_);
+        slab_->task = taskKey_;
     }
 }
 
+/**
+ * @brief Publish the pending sequences as one slab.
+ * 
+ * @return void
+ */
+void ResultBatcher::flush() {
+    if (slab_->count > 0) {
+        publish();
+    }
+}
+
+/**
+ * @brief Publish the pending sequences and, in ordered mode, report the running task as done.
+ * 
+ * @return void
+ */
+void ResultBatcher::end_task() {
+    if (ordered_) {
+        slab_->taskDone = true;
+        publish();
+    } else {
+        flush();
+    }
+}
+
+/**
+ * @brief Tell the output thread about a task split off the running one.
+ * 
+ * @param task The task handed to the pool.
+ * 
+ * @return void
+ * 
+ * @details Sent before the running task can be reported done, which is what lets the
+ * output thread know no earlier task is still to come.
+ */
+void ResultBatcher::announce(const SearchTask& task) {
+    if (ordered_) {
+        ResultSlab* slab = pool_.acquire();
+        assign_order_key(task, slab->task);
+        channel_.push(slab);
+    }
+}
+
+/**
+ * @brief Send the current slab and start the next one for the same task.
+ * 
+ * @return void
+ * 
+ * @details Slabs are reserved in full when they are first allocated and keep their
+ * capacity when recycled, so neither encoding nor publishing allocates.
+ */
+void ResultBatcher::publish() {
+    ResultSlab* next = pool_.acquire();
+    if (ordered_ && !slab_->taskDone) {
+        next->task = taskKey_;
+    }
+    channel_.push(slab_);
+    slab_ = next;
+}
+
 /**
  * @brief Thread function for outputting valid sequences.
  * 
- * @param resultChannel Channel from which to receive valid sequences.
- * @param out Output stream to write the sequences.
+ * @param resultChannel Channel from which to receive the encoded sequences.
+ * @param writer Writer of the output file; flushed once the channel is closed and drained.
  * @param sequencesFound Atomic counter for the number of sequences found.
+ * @param limit Stop writing, and cancel the search, after this many sequences.
  * 
  * @return void
  * 
  * @details This function runs in a separate thread to output valid sequences as they are found.
+ * It drains every published slab at once, so it is not woken once per sequence. The workers
+ * have already encoded the sequences, so all that is left here is copying bytes and handing
+ * each slab back to the worker it came from.
  */
-void output_thread(Channel<std::vector<int>>& resultChannel,
-                   std::ostream& out,
-                   std::atomic<std::size_t>& sequencesFound) {
-    std::vector<int> seq;
-    while (resultChannel.pop(seq)) {
-        sequencesFound.fetch_add(1, std::memory_order_relaxed);
-
-        for (std::size_t i = 0; i < seq.size(); ++i) {
-            out << seq[i];
-            if (i + 1 < seq.size()) {
-                out << ", ";
+void output_thread(ResultChannel& resultChannel,
+                   SeqFileWriter& writer,
+                   std::atomic<std::size_t>& sequencesFound,
+                   const OutputLimit& limit) {
+    std::size_t room = limit.sequences > 0 ? limit.sequences : std::numeric_limits<std::size_t>::max();
+    std::vector<ResultSlab*> slabs;
+    while (resultChannel.pop_all(slabs)) {
+        for (ResultSlab* slab : slabs) {
+            // Past the limit slabs are only handed back, so workers blocked on a full channel get going and stop
+            const std::size_t count = std::min(slab->count, room);
+            if (count > 0) {
+                const std::size_t bytes = count == slab->count
+                    ? slab->bytes.size()
+                    : writer.encoder().prefix_bytes(slab->bytes.data(), slab->bytes.size(), count);
+                writer.write_encoded(slab->bytes.data(), bytes);
+                room -= count;
+                if (room == 0 && limit.pool) {
+                    limit.pool->cancel();
+                }
             }
+            slab->owner->release(slab);
+            // Counted once handed to the writer, so a checkpoint can wait for it to catch up
+            sequencesFound.fetch_add(count, std::memory_order_release);
         }
-        out << '\n';
+        slabs.clear();
     }
-}
\ No newline at end of file
+    writer.flush();
+}
@@ -0,0 +1,157 @@
+/**
+ * @file src/ns1d0_api.cpp
+ *
+ * @brief Implementation of the libns1d0 callback and generator interface.
+ */
+
+#include "ns1d0_api.h"
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @brief How often ns1d0_search() looks at the caller's cancel flag.
+ */
+static constexpr std::chrono::milliseconds kCancelPollInterval{1};
+
+/**
+ * @brief The configuration of NS1D0(n).
+ *
+ * @param n An odd modulus greater than 1.
+ *
+ * @return NS1D0Config The length and forbidden value that go with n.
+ */
+NS1D0Config ns1d0_config(int n) {
+    NS1D0Config cfg;
+    cfg.n = n;
+    cfg.targetLength = (n - 1) / 2 + 1;
+    cfg.forbidden = (n + 1) / 2; // ceil(n/2) since n is odd
+    return cfg;
+}
+
+/**
+ * @brief Find the sequences of NS1D0(n) and hand each one to a callback.
+ *
+ * @param n An odd modulus greater than 1.
+ * @param options Threads, limit, cancellation and search knobs.
+ * @param callback Receives the sequences, on the worker threads.
+ *
+ * @return NS1D0SearchResult What was searched and found; empty and not complete for an invalid n.
+ *
+ * @details The workers are the ones bin/sequence runs, with the callback in place of
+ * the result channel. Stopping, for whatever reason, cancels the task pool: queued
+ * tasks are dropped and running ones are abandoned at their next node.
+ */
+NS1D0SearchResult ns1d0_search(int n, const NS1D0SearchOptions& options, const NS1D0Callback& callback) {
+    using Clock = std::chrono::steady_clock;
+    NS1D0SearchResult result;
+    if (n <= 1 || n % 2 != 1) {
+        return result;
+    }
+    const auto start = Clock::now();
+    const NS1D0Config cfg = ns1d0_config(n);
+
+    const int workerCount = worker_count(options.threads);
+    WorkStealingPool pool(workerCount);
+    const std::vector<SearchTask> tasks = initial_search_tasks(cfg);
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        pool.push(static_cast<int>(i % workerCount), tasks[i]);
+    }
+
+    // Count what reaches the callback, and stop at the limit
+    std::atomic<std::size_t> delivered{0};
+    SearchOptions opts = options.search;
+    opts.countOnly = false;
+    opts.breakdown = false;
+    opts.ordered = false;
+    opts.onResult = [&](const int* seq, std::size_t length) {
+        const std::size_t index = delivered.fetch_add(1, std::memory_order_relaxed);
+        if (options.limit > 0 && index >= options.limit) {
+            return false;
+        }
+        const bool more = callback(SequenceView{seq, length});
+        return more && (options.limit == 0 || index + 1 < options.limit);
+    };
+
+    ResultChannel unused;
+    std::atomic<std::size_t> nodesExpanded{0};
+    std::atomic<int> running{workerCount};
+    std::vector<SearchCounts> workerCounts(workerCount);
+    std::vector<LiveProgress> liveProgress(workerCount);
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([&, i] {
+            search_worker(i, pool, cfg, opts, unused, workerCounts[i], nodesExpanded, liveProgress[i]);
+            running.fetch_sub(1);
+        });
+    }
+
+    if (options.cancel) {
+        while (running.load() > 0) {
+            if (options.cancel->load()) {
+                pool.cancel();
+                break;
+            }
+            std::this_thread::sleep_for(kCancelPollInterval);
+        }
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    const std::size_t found = delivered.load();
+    result.sequences = options.limit > 0 ? std::min(found, options.limit) : found;
+    result.nodes = nodesExpanded.load();
+    result.complete = !pool.cancelled();
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+/**
+ * @brief Start searching in the background.
+ *
+ * @param n An odd modulus greater than 1.
+ * @param options Threads, limit and search knobs; cancel is replaced by the generator's own flag.
+ * @param capacity Sequences the workers may run ahead of the consumer.
+ */
+NS1D0Generator::NS1D0Generator(int n, NS1D0SearchOptions options, std::size_t capacity)
+    : channel_(capacity) {
+    options.cancel = &cancel_;
+    thread_ = std::thread([this, n, options] {
+        result_ = ns1d0_search(n, options, [this](SequenceView seq) {
+            // Fails once the generator is stopped, which stops the search
+            return channel_.push(std::vector<int>(seq.begin(), seq.end()));
+        });
+        channel_.close();
+    });
+}
+
+NS1D0Generator::~NS1D0Generator() {
+    stop();
+    thread_.join();
+}
+
+/**
+ * @brief Take the next sequence.
+ *
+ * @param out Receives the sequence.
+ *
+ * @return true If there was one; false once the search is over and everything was taken.
+ */
+bool NS1D0Generator::next(std::vector<int>& out) {
+    return channel_.pop(out);
+}
+
+/**
+ * @brief Cancel the search.
+ *
+ * @return void
+ *
+ * @details Workers blocked on a full channel fail their push and stop. next() still
+ * returns what was queued before.
+ */
+void NS1D0Generator::stop() {
+    cancel_.store(true);
+    channel_.close();
+}
@@ -0,0 +1,408 @@
+/**
+ * @file src/pair_search.cpp
+ *
+ * @brief Implementation of the difference-pair search engine.
+ *
+ * @details See include/pair_search.h for the formulation. The worker loop, the
+ * splitting and the result path follow dfs_search() in src/ns1d0.cpp; only the
+ * state and the choice of what to branch on differ.
+ */
+
+#include "pair_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Values still to place before a subtree is worth handing to another worker.
+ */
+static constexpr int kMinSplitOpen = 3;
+
+/**
+ * @brief Workers publish their live progress whenever their node count is a multiple of this mask plus one.
+ */
+static constexpr std::size_t kProgressMask = (std::size_t{1} << 14) - 1;
+
+/**
+ * @brief The two ends a value can be placed at.
+ */
+enum class End : std::uint8_t {
+    Left,   // after a_0 = 0 and the values placed there so far
+    Right   // before a_{k-1} = 1 and the values placed there so far
+};
+
+/**
+ * @class PairState
+ *
+ * @brief The two ends of a partial sequence, with the pairs and values they use, as single-word masks.
+ *
+ * @details diffs has bit d set for every difference d in 1..n-1 whose pair {d, n - d}
+ * is still unused; it is symmetric, so the same mask serves both ends. blocked has a
+ * bit for every value that can no longer be placed: those used, their Rule 5
+ * partners, and the forbidden value. The candidates of an end at value x are diffs
+ * rotated left by x, minus blocked.
+ */
+class PairState {
+    public:
+        explicit PairState(const NS1D0Config& cfg)
+            : cfg_(cfg),
+              full_((std::uint64_t{1} << cfg.n) - 1),
+              interior_(std::max(0, cfg.targetLength - 2)) {
+            diffs_ = full_ & ~std::uint64_t{1};
+            blocked_ = bit(0) | bit(1) | bit(cfg.forbidden);
+            left_.reserve(interior_ + 1);
+            right_.reserve(interior_ + 1);
+            steps_.reserve(interior_);
+            path_.reserve(interior_);
+            left_.push_back(0);
+            right_.push_back(1);
+        }
+
+        int n() const { return cfg_.n; }
+
+        // Values placed so far, i.e. the depth of the node.
+        int placed() const { return static_cast<int>(steps_.size()); }
+
+        // Values between 0 and 1 still to place.
+        int open() const { return interior_ - placed(); }
+
+        // The values placed so far, in the order they were placed.
+        const std::vector<int>& path() const { return path_; }
+
+        // The values that can be placed at an end.
+        std::uint64_t candidates(End end) const {
+            const int x = end == End::Left ? left_.back() : right_.back();
+            return rotate(diffs_, x) & ~blocked_;
+        }
+
+        // The end with fewer candidates, left on a tie, and its candidates.
+        End most_constrained(std::uint64_t& candidates) const {
+            const std::uint64_t left = this->candidates(End::Left);
+            const std::uint64_t right = this->candidates(End::Right);
+            if (__builtin_popcountll(right) < __builtin_popcountll(left)) {
+                candidates = right;
+                return End::Right;
+            }
+            candidates = left;
+            return End::Left;
+        }
+
+        // Place v, a candidate of end.
+        void push(End end, int v) {
+            std::vector<int>& side = end == End::Left ? left_ : right_;
+            const int gap = v >= side.back() ? v - side.back() : v - side.back() + cfg_.n;
+            steps_.push_back(Step{end, diffs_, blocked_});
+            diffs_ &= ~(bit(gap) | bit(cfg_.n - gap));
+            blocked_ |= bit(v) | bit((cfg_.n + 1 - v) % cfg_.n);
+            side.push_back(v);
+            path_.push_back(v);
+        }
+
+        void pop() {
+            const Step& step = steps_.back();
+            (step.end == End::Left ? left_ : right_).pop_back();
+            diffs_ = step.diffs;
+            blocked_ = step.blocked;
+            steps_.pop_back();
+            path_.pop_back();
+        }
+
+        // With every value placed: whether the pair left joins the two ends.
+        bool closes() const {
+            return (diffs_ >> mod(right_.back() - left_.back())) & 1u;
+        }
+
+        // The sequence, left end then the right end read backwards.
+        void sequence(std::vector<int>& out) const {
+            out.assign(left_.begin(), left_.end());
+            out.insert(out.end(), right_.rbegin(), right_.rend());
+        }
+
+    private:
+        struct Step {
+            End end;
+            std::uint64_t diffs;
+            std::uint64_t blocked;
+        };
+
+        static std::uint64_t bit(int i) { return std::uint64_t{1} << i; }
+
+        int mod(int a) const { return ((a % cfg_.n) + cfg_.n) % cfg_.n; }
+
+        // m rotated left by s (0 <= s < n) within n bits.
+        std::uint64_t rotate(std::uint64_t m, int s) const {
+            return s == 0 ? m : ((m << s) | (m >> (cfg_.n - s))) & full_;
+        }
+
+        NS1D0Config cfg_;
+        std::uint64_t full_;
+        int interior_;
+        std::uint64_t diffs_;
+        std::uint64_t blocked_;
+        std::vector<int> left_;     // a_0, a_1, ...
+        std::vector<int> right_;    // a_{k-1}, a_{k-2}, ...
+        std::vector<Step> steps_;
+        std::vector<int> path_;
+};
+
+/**
+ * @struct PairContext
+ *
+ * @brief Everything one worker of the difference-pair engine needs while running tasks.
+ *
+ * @details cursor and last work as in WorkerContext: cursor[d] is the value being
+ * explored at depth d and last[d] is one past the last value this worker still owns there.
+ */
+struct PairContext {
+    int worker;
+    WorkStealingPool& pool;
+    ResultBatcher results;
+    PairState state;
+    std::vector<int> cursor;
+    std::vector<int> last;
+    int baseDepth;                    // first depth owned by the running task
+    std::vector<int> seq;             // scratch buffer for a complete sequence
+    bool countOnly;
+    const ResultCallback* onResult;   // receives results in place of the channel, if set
+    SearchCounts counts;
+    SearchCounts& report;
+    LiveProgress& live;
+};
+
+/**
+ * @brief Record the complete sequence the state holds.
+ *
+ * @param ctx The worker's context.
+ *
+ * @return void
+ */
+static void emit_result(PairContext& ctx) {
+    ++ctx.counts.sequences;
+    ctx.state.sequence(ctx.seq);
+    if (ctx.onResult) {
+        if (!ctx.pool.cancelled() && !(*ctx.onResult)(ctx.seq.data(), ctx.seq.size())) {
+            ctx.pool.cancel();
+        }
+        return;
+    }
+    if (ctx.countOnly) {
+        if (!ctx.counts.bySecond.empty()) {
+            ++ctx.counts.bySecond[ctx.seq[1]];
+        }
+        return;
+    }
+    ctx.results.add(ctx.seq.data());
+}
+
+/**
+ * @brief Hand the shallowest unexplored part of this worker's tree to the pool, as split_shallowest() does.
+ *
+ * @param ctx The worker's context.
+ *
+ * @return void
+ */
+static void split_shallowest(PairContext& ctx) {
+    const std::vector<int>& path = ctx.state.path();
+    const int interior = ctx.state.placed() + ctx.state.open();
+    for (int d = ctx.baseDepth; d < ctx.state.placed(); ++d) {
+        if (interior - d < kMinSplitOpen) {
+            return;
+        }
+        if (ctx.cursor[d] + 1 < ctx.last[d]) {
+            SearchTask task;
+            task.prefix.assign(path.begin(), path.begin() + d);
+            task.first = ctx.cursor[d] + 1;
+            task.last = ctx.last[d];
+            ctx.last[d] = ctx.cursor[d] + 1;
+            ctx.pool.push(ctx.worker, std::move(task));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Publish the worker's counters for the progress reporter.
+ */
+static void publish_progress(PairContext& ctx) {
+    ctx.live.nodes.store(ctx.counts.nodes, std::memory_order_relaxed);
+    ctx.live.sequences.store(ctx.counts.sequences, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Search below the current node, trying the values from first up at its most constrained end.
+ *
+ * @param ctx The worker's context; the state has at least one value still to place.
+ * @param first The first value to try.
+ *
+ * @return void
+ *
+ * @details Values are tried in increasing order up to ctx.last for the depth, which
+ * split_shallowest() may lower. Placing the last open value completes the sequence
+ * if the pair left over closes the gap between the ends; nothing is searched below it.
+ */
+static void pair_search(PairContext& ctx, int first) {
+    PairState& state = ctx.state;
+    const int depth = state.placed();
+
+    if (ctx.pool.cancelled()) {
+        return;
+    }
+    if (ctx.pool.hungry() && ctx.pool.queued(ctx.worker) == 0) {
+        split_shallowest(ctx);
+    }
+
+    std::uint64_t candidates;
+    const End end = state.most_constrained(candidates);
+    candidates &= ~((std::uint64_t{1} << first) - 1);
+    while (candidates) {
+        const int v = __builtin_ctzll(candidates);
+        if (v >= ctx.last[depth]) {
+            break;
+        }
+        candidates &= candidates - 1;
+
+        ++ctx.counts.nodes;
+        if ((ctx.counts.nodes & kProgressMask) == 0) {
+            publish_progress(ctx);
+        }
+
+        ctx.cursor[depth] = v;
+        state.push(end, v);
+        if (state.open() > 0) {
+            ctx.last[depth + 1] = state.n();
+            pair_search(ctx, 0);
+        } else if (state.closes()) {
+            emit_result(ctx);
+        }
+        state.pop();
+    }
+}
+
+/**
+ * @brief Parse an engine name ("dfs" or "pairs").
+ *
+ * @param name The name to parse.
+ * @param out Receives the engine.
+ *
+ * @return true If the name is known.
+ */
+bool parse_search_engine(const std::string& name, SearchEngine& out) {
+    if (name == "dfs") {
+        out = SearchEngine::Dfs;
+    } else if (name == "pairs") {
+        out = SearchEngine::Pairs;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The initial tasks of the difference-pair engine, one per candidate of the root.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ *
+ * @return std::vector<SearchTask> The tasks that together cover the whole search.
+ *
+ * @details For n = 3 there is nothing to place between 0 and 1; the single task is the root itself.
+ */
+std::vector<SearchTask> initial_pair_tasks(const NS1D0Config& cfg) {
+    const PairState root(cfg);
+    if (root.open() == 0) {
+        return {SearchTask{{}, 0, cfg.n}};
+    }
+    std::uint64_t candidates;
+    root.most_constrained(candidates);
+    std::vector<SearchTask> tasks;
+    for (; candidates; candidates &= candidates - 1) {
+        const int v = __builtin_ctzll(candidates);
+        tasks.push_back(SearchTask{{}, v, v + 1});
+    }
+    return tasks;
+}
+
+/**
+ * @brief Run one task to the end and hand the counters back.
+ *
+ * @param ctx The worker's context, at the root.
+ * @param task The task.
+ *
+ * @return void
+ */
+static void run_task(PairContext& ctx, const SearchTask& task) {
+    // Each value goes to the end the search chose for it, which replaying chooses again
+    for (int v : task.prefix) {
+        std::uint64_t candidates;
+        ctx.state.push(ctx.state.most_constrained(candidates), v);
+    }
+    ctx.baseDepth = ctx.state.placed();
+    ctx.last[ctx.baseDepth] = task.last;
+
+    if (ctx.state.open() > 0) {
+        pair_search(ctx, task.first);
+    } else if (ctx.state.closes()) {
+        emit_result(ctx);
+    }
+    ctx.results.flush();
+
+    while (ctx.state.placed() > 0) {
+        ctx.state.pop();
+    }
+    ctx.report = ctx.counts;
+    publish_progress(ctx);
+}
+
+/**
+ * @brief Worker function of the difference-pair engine.
+ *
+ * @param workerIndex The index of this worker thread.
+ * @param pool The pool to take search tasks from; seed it with initial_pair_tasks().
+ * @param cfg Configuration containing the target length and other parameters; n <= kMaxPairSearchN.
+ * @param opts Search options; symmetry, lookahead, specialized and ordered are ignored.
+ * @param resultChannel Channel to send the valid sequences found, encoded in opts.format; unused in count-only mode.
+ * @param counts Receives this worker's counters after every task and at the end.
+ * @param nodesExpanded Atomic counter for the number of nodes expanded during the search.
+ * @param live Where this worker publishes its progress while the search runs.
+ *
+ * @return void
+ */
+void pair_search_worker(int workerIndex,
+                        WorkStealingPool& pool,
+                        const NS1D0Config& cfg,
+                        const SearchOptions& opts,
+                        ResultChannel& resultChannel,
+                        SearchCounts& counts,
+                        std::atomic<std::size_t>& nodesExpanded,
+                        LiveProgress& live) {
+    using Clock = std::chrono::steady_clock;
+
+    PairContext ctx{workerIndex,
+                    pool,
+                    ResultBatcher(resultChannel, opts.format, cfg.n, cfg.targetLength, false, opts.resultBatch),
+                    PairState(cfg),
+                    std::vector<int>(cfg.targetLength + 1, 0),
+                    std::vector<int>(cfg.targetLength + 1, 0),
+                    0,
+                    {},
+                    opts.countOnly,
+                    opts.onResult ? &opts.onResult : nullptr,
+                    {},
+                    counts,
+                    live};
+    if (opts.countOnly && opts.breakdown) {
+        ctx.counts.bySecond.assign(cfg.n, 0);
+    }
+
+    SearchTask task;
+    while (pool.next(workerIndex, task)) {
+        const auto start = Clock::now();
+        run_task(ctx, task);
+        pool.task_done();
+        pool.add_busy_time(workerIndex, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    nodesExpanded.fetch_add(ctx.counts.nodes, std::memory_order_relaxed);
+    ctx.report = ctx.counts;
+    publish_progress(ctx);
+}
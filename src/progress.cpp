@@ -0,0 +1,235 @@
+/**
+ * @file src/progress.cpp
+ *
+ * @brief Implementation of the progress reporter, the JSON run summary and the rule statistics table.
+ */
+
+#include "progress.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Short name of a prune reason, as used in reports and the JSON dump.
+ */
+const char* prune_reason_name(PruneReason reason) {
+    switch (reason) {
+        case PruneReason::None: return "none";
+        case PruneReason::Length: return "length";
+        case PruneReason::Range: return "range";
+        case PruneReason::Start: return "start";
+        case PruneReason::Unique: return "unique";
+        case PruneReason::OneAtEnd: return "one_at_end";
+        case PruneReason::Forbidden: return "forbidden";
+        case PruneReason::PairExclusion: return "pair_exclusion";
+        case PruneReason::DifferencePair: return "difference_pair";
+        case PruneReason::Symmetry: return "symmetry";
+        case PruneReason::FinalStep: return "final_step";
+        case PruneReason::PairCoverage: return "pair_coverage";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief The reasons that can actually prune in dfs_search(), in rule order.
+ */
+static constexpr PruneReason kReportedReasons[] = {
+    PruneReason::Unique,
+    PruneReason::OneAtEnd,
+    PruneReason::Forbidden,
+    PruneReason::PairExclusion,
+    PruneReason::DifferencePair,
+    PruneReason::Symmetry,
+    PruneReason::FinalStep,
+    PruneReason::PairCoverage
+};
+
+ProgressReporter::ProgressReporter(double intervalSeconds,
+                                   const std::vector<LiveProgress>& live,
+                                   double baseExplored,
+                                   std::size_t baseSequences,
+                                   std::ostream& out)
+    : intervalSeconds_(intervalSeconds),
+      live_(live),
+      baseExplored_(baseExplored),
+      baseSequences_(baseSequences),
+      out_(out) {}
+
+ProgressReporter::~ProgressReporter() {
+    stop();
+}
+
+/**
+ * @brief Start the background thread.
+ *
+ * @return void
+ */
+void ProgressReporter::start() {
+    start_ = Clock::now();
+    last_ = start_;
+    thread_ = std::thread(&ProgressReporter::run, this);
+}
+
+/**
+ * @brief Stop the background thread.
+ *
+ * @return void
+ */
+void ProgressReporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @brief Report every interval until stopped.
+ *
+ * @return void
+ */
+void ProgressReporter::run() {
+    const auto interval = std::chrono::duration<double>(intervalSeconds_);
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!cv_.wait_for(lock, interval, [&] { return stopping_; })) {
+        report();
+    }
+}
+
+/**
+ * @brief Print one progress line.
+ *
+ * @return void
+ *
+ * @details Rates are over the last interval; the completion estimate extrapolates the average
+ * rate of this run, in tree weight per second, to the weight that is left.
+ */
+void ProgressReporter::report() {
+    std::size_t nodes = 0;
+    std::size_t sequences = 0;
+    double explored = baseExplored_;
+    for (const LiveProgress& p : live_) {
+        nodes += p.nodes.load(std::memory_order_relaxed);
+        sequences += p.sequences.load(std::memory_order_relaxed);
+        explored += p.explored.load(std::memory_order_relaxed);
+    }
+    if (explored > 1.0) explored = 1.0;
+
+    const auto now = Clock::now();
+    const double elapsed = std::chrono::duration<double>(now - start_).count();
+    const double window = std::chrono::duration<double>(now - last_).count();
+    const double nodeRate = window > 0.0 ? (nodes - lastNodes_) / window : 0.0;
+    const double sequenceRate = window > 0.0 ? (sequences - lastSequences_) / window : 0.0;
+    lastNodes_ = nodes;
+    lastSequences_ = sequences;
+    last_ = now;
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1)
+         << "[" << elapsed << " s] " << 100.0 * explored << "% explored"
+         << ", " << nodes << " nodes (" << nodeRate << "/s)"
+         << ", " << baseSequences_ + sequences << " sequences (" << sequenceRate << "/s)";
+    const double done = explored - baseExplored_;
+    if (done > 0.0) {
+        line << ", ETA " << elapsed * (1.0 - explored) / done << " s";
+    }
+    out_ << line.str() << std::endl;
+}
+
+/**
+ * @brief Write one SearchCounts as the members of a JSON object.
+ */
+static void write_counts_json(std::ostream& out, const SearchCounts& counts, const char* indent) {
+    out << indent << "\"nodes\": " << counts.nodes << ",\n";
+    out << indent << "\"sequences\": " << counts.sequences << ",\n";
+    out << indent << "\"lookahead_pruned\": {\"final_step\": " << counts.finalStepPruned
+        << ", \"pair_coverage\": " << counts.pairCoveragePruned << "}";
+}
+
+/**
+ * @brief Write a run summary as JSON.
+ *
+ * @param path The file to write.
+ * @param summary The run to describe.
+ *
+ * @return true If the file was written.
+ */
+bool write_stats_json(const std::string& path, const RunSummary& summary) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    const SearchCounts& total = summary.total;
+    out << "{\n";
+    out << "  \"n\": " << summary.n << ",\n";
+    out << "  \"symmetry\": " << (summary.symmetry ? "true" : "false") << ",\n";
+    out << "  \"seconds\": " << summary.seconds << ",\n";
+    write_counts_json(out, total, "  ");
+    out << ",\n";
+    out << "  \"nodes_per_second\": " << (summary.seconds > 0.0 ? total.nodes / summary.seconds : 0.0) << ",\n";
+
+    out << "  \"workers\": [";
+    for (std::size_t w = 0; w < summary.workers.size(); ++w) {
+        const WorkerStats& st = summary.workerStats[w];
+        out << (w ? "," : "") << "\n    {\n";
+        write_counts_json(out, summary.workers[w], "      ");
+        out << ",\n      \"busy_seconds\": " << st.busySeconds
+            << ",\n      \"idle_seconds\": " << st.idleSeconds
+            << ",\n      \"tasks\": " << st.tasksRun
+            << ",\n      \"stolen\": " << st.tasksStolen << "\n    }";
+    }
+    out << "\n  ],\n";
+
+    // Per-depth counters only exist in an instrumented build
+    out << "  \"instrumented\": " << (SearchStats::enabled ? "true" : "false") << ",\n";
+    out << "  \"depths\": [";
+    const SearchStats& stats = total.stats;
+    for (int d = 0; d < stats.depths(); ++d) {
+        out << (d ? "," : "") << "\n    {\"depth\": " << d << ", \"visited\": " << stats.visited(d)
+            << ", \"pruned\": {";
+        bool firstReason = true;
+        for (PruneReason r : kReportedReasons) {
+            out << (firstReason ? "" : ", ") << "\"" << prune_reason_name(r) << "\": " << stats.pruned(d, r);
+            firstReason = false;
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n";
+    out << "}\n";
+
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Print the per-depth, per-rule counters as a table. Prints nothing unless built with NS1D0_STATS.
+ *
+ * @param stats The merged counters.
+ * @param out Where to print the table.
+ *
+ * @return void
+ */
+void print_search_stats(const SearchStats& stats, std::ostream& out) {
+    if (!SearchStats::enabled) {
+        return;
+    }
+
+    out << "Pruning by rule and depth:" << std::endl;
+    out << std::setw(6) << "depth" << std::setw(14) << "visited";
+    for (PruneReason r : kReportedReasons) {
+        out << std::setw(16) << prune_reason_name(r);
+    }
+    out << std::endl;
+
+    for (int d = 0; d < stats.depths(); ++d) {
+        out << std::setw(6) << d << std::setw(14) << stats.visited(d);
+        for (PruneReason r : kReportedReasons) {
+            out << std::setw(16) << stats.pruned(d, r);
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,247 @@
+/**
+ * @file src/reorder.cpp
+ *
+ * @brief Implementation of the reorder buffer behind ordered output.
+ */
+
+#include "reorder.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Size of the pieces spilled results are read back in.
+ */
+static constexpr std::size_t kReadBackBytes = std::size_t{4} << 20;
+
+/**
+ * @brief The position of a task in the lexicographic order: its prefix followed by its first candidate.
+ *
+ * @param task The task.
+ *
+ * @return std::vector<int> The key; keys of disjoint tasks sort like the sequences they find.
+ */
+std::vector<int> task_order_key(const SearchTask& task) {
+    std::vector<int> key;
+    assign_order_key(task, key);
+    return key;
+}
+
+/**
+ * @brief Overwrite key with a task's order key, reusing its storage.
+ *
+ * @param task The task.
+ * @param key Receives the key.
+ *
+ * @return void
+ */
+void assign_order_key(const SearchTask& task, std::vector<int>& key) {
+    key.assign(task.prefix.begin(), task.prefix.end());
+    key.push_back(task.first);
+}
+
+/**
+ * @brief Announce tasks to the output thread of an ordered run, before any worker starts.
+ *
+ * @param channel The result channel.
+ * @param tasks The tasks the pool is seeded with.
+ *
+ * @return void
+ */
+void announce_tasks(ResultChannel& channel, const std::vector<SearchTask>& tasks) {
+    SlabPool& pool = channel.new_pool(0);
+    for (const SearchTask& task : tasks) {
+        ResultSlab* slab = pool.acquire();
+        assign_order_key(task, slab->task);
+        channel.push(slab);
+    }
+}
+
+ReorderBuffer::ReorderBuffer(SeqFileWriter& writer, std::size_t memoryLimit, std::string spillPath)
+    : writer_(writer),
+      memoryLimit_(memoryLimit),
+      spillPath_(std::move(spillPath)) {}
+
+ReorderBuffer::~ReorderBuffer() {
+    if (spillFd_ >= 0) {
+        ::close(spillFd_);
+    }
+}
+
+/**
+ * @brief Take one slab: write it if its task is the first one pending, buffer it otherwise.
+ *
+ * @param slab The slab; an empty one only announces its task. The caller still owns it.
+ *
+ * @return void
+ */
+void ReorderBuffer::add(const ResultSlab& slab) {
+    auto it = pending_.find(slab.task);
+    if (it == pending_.end()) {
+        it = pending_.emplace(slab.task, Pending{}).first;
+    }
+    stats_.peakPending = std::max(stats_.peakPending, pending_.size());
+
+    if (it == pending_.begin()) {
+        writer_.write_encoded(slab.bytes.data(), slab.bytes.size());
+    } else if (!slab.bytes.empty()) {
+        it->second.bytes.insert(it->second.bytes.end(), slab.bytes.begin(), slab.bytes.end());
+        memory_ += slab.bytes.size();
+        stats_.peakBytes = std::max(stats_.peakBytes, memory_);
+        if (memory_ > memoryLimit_) {
+            spill();
+        }
+    }
+
+    if (slab.taskDone) {
+        it->second.done = true;
+        advance();
+    }
+}
+
+/**
+ * @brief Write whatever is still pending, in order.
+ *
+ * @return void
+ */
+void ReorderBuffer::finish() {
+    while (!pending_.empty()) {
+        write_out(pending_.begin()->second);
+        pending_.erase(pending_.begin());
+    }
+}
+
+/**
+ * @brief Retire finished tasks from the front, catching up on the buffer of each new first task.
+ *
+ * @return void
+ */
+void ReorderBuffer::advance() {
+    while (!pending_.empty() && pending_.begin()->second.done) {
+        pending_.erase(pending_.begin());
+        if (!pending_.empty()) {
+            write_out(pending_.begin()->second);
+        }
+    }
+}
+
+/**
+ * @brief Write a task's buffered results, spilled parts first, and release them.
+ *
+ * @param task The task, which must be the first one pending.
+ *
+ * @return void
+ */
+void ReorderBuffer::write_out(Pending& task) {
+    for (const auto& [offset, size] : task.spilled) {
+        scratch_.resize(std::min(size, kReadBackBytes));
+        for (std::size_t done = 0; done < size;) {
+            const std::size_t piece = std::min(size - done, scratch_.size());
+            const ssize_t got = pread(spillFd_, scratch_.data(), piece, static_cast<off_t>(offset + done));
+            if (got <= 0) {
+                if (complete_) {
+                    error_ = "could not read back the reorder spill file " + spillPath_;
+                    complete_ = false;
+                }
+                break;
+            }
+            writer_.write_encoded(scratch_.data(), static_cast<std::size_t>(got));
+            done += static_cast<std::size_t>(got);
+        }
+    }
+    task.spilled.clear();
+
+    writer_.write_encoded(task.bytes.data(), task.bytes.size());
+    memory_ -= task.bytes.size();
+    std::vector<char>().swap(task.bytes);
+}
+
+/**
+ * @brief Move every buffered result to the spill file.
+ *
+ * @return void
+ *
+ * @details The first task is never buffered, so everything in memory waits on an
+ * earlier task and may as well wait on disk. If the spill file cannot be created
+ * the results stay in memory.
+ */
+void ReorderBuffer::spill() {
+    if (!open_spill_file()) {
+        return;
+    }
+    for (auto& [key, task] : pending_) {
+        if (task.bytes.empty()) continue;
+
+        std::size_t written = 0;
+        while (written < task.bytes.size()) {
+            const ssize_t put = pwrite(spillFd_, task.bytes.data() + written, task.bytes.size() - written,
+                                       static_cast<off_t>(spillEnd_ + written));
+            if (put <= 0) {
+                if (error_.empty()) {
+                    error_ = "could not write the reorder spill file " + spillPath_ + "; results were kept in memory";
+                }
+                spillFailed_ = true;
+                return;
+            }
+            written += static_cast<std::size_t>(put);
+        }
+        task.spilled.emplace_back(spillEnd_, written);
+        spillEnd_ += written;
+        stats_.spilledBytes += written;
+        memory_ -= written;
+        std::vector<char>().swap(task.bytes);
+    }
+}
+
+/**
+ * @brief Create the spill file on first use and unlink it, so it disappears with the process.
+ *
+ * @return true If the spill file is open.
+ */
+bool ReorderBuffer::open_spill_file() {
+    if (spillFd_ >= 0) {
+        return !spillFailed_;
+    }
+    if (spillFailed_) {
+        return false;
+    }
+    spillFd_ = ::open(spillPath_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (spillFd_ < 0) {
+        if (error_.empty()) {
+            error_ = "could not create " + spillPath_ + "; results were kept in memory";
+        }
+        spillFailed_ = true;
+        return false;
+    }
+    ::unlink(spillPath_.c_str());
+    return true;
+}
+
+/**
+ * @brief Thread function for writing the results of an ordered run.
+ *
+ * @param resultChannel Channel from which to receive the tagged slabs.
+ * @param buffer The reorder buffer in front of the output file's writer.
+ * @param writer The writer; flushed once the channel is closed and drained.
+ * @param sequencesFound Atomic counter for the number of sequences found.
+ *
+ * @return void
+ */
+void ordered_output_thread(ResultChannel& resultChannel,
+                           ReorderBuffer& buffer,
+                           SeqFileWriter& writer,
+                           std::atomic<std::size_t>& sequencesFound) {
+    std::vector<ResultSlab*> slabs;
+    while (resultChannel.pop_all(slabs)) {
+        for (ResultSlab* slab : slabs) {
+            const std::size_t count = slab->count;
+            buffer.add(*slab);
+            slab->owner->release(slab);
+            sequencesFound.fetch_add(count, std::memory_order_release);
+        }
+        slabs.clear();
+    }
+    buffer.finish();
+    writer.flush();
+}
@@ -0,0 +1,81 @@
+/**
+ * @file src/result_slab.cpp
+ *
+ * @brief Implementation of the slab pools behind the result channel.
+ */
+
+#include "result_slab.h"
+
+SlabPool::SlabPool(std::size_t slabBytes): slabBytes_(slabBytes) {}
+
+/**
+ * @brief Take an empty slab, reusing a returned one if there is any.
+ *
+ * @return ResultSlab* A slab with no sequences, no task and room for a full batch.
+ */
+ResultSlab* SlabPool::acquire() {
+    if (!free_) {
+        free_ = returned_.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (free_) {
+        ResultSlab* slab = free_;
+        free_ = slab->next;
+        slab->next = nullptr;
+        return slab;
+    }
+
+    slabs_.push_back(std::make_unique<ResultSlab>());
+    ResultSlab* slab = slabs_.back().get();
+    slab->bytes.reserve(slabBytes_);
+    slab->owner = this;
+    allocated_.fetch_add(1, std::memory_order_relaxed);
+    return slab;
+}
+
+/**
+ * @brief Give a consumed slab back to its pool.
+ *
+ * @param slab A slab acquired from this pool.
+ *
+ * @return void
+ *
+ * @details The slab is emptied here, on the consumer's thread, keeping its capacity.
+ */
+void SlabPool::release(ResultSlab* slab) {
+    slab->bytes.clear();
+    slab->count = 0;
+    slab->task.clear();
+    slab->taskDone = false;
+
+    slab->next = returned_.load(std::memory_order_relaxed);
+    while (!returned_.compare_exchange_weak(slab->next, slab,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief A new pool for one producer.
+ *
+ * @param recordBytes The most bytes one encoded sequence takes.
+ *
+ * @return SlabPool& The pool; it lives as long as the channel.
+ */
+SlabPool& ResultChannel::new_pool(std::size_t recordBytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return pools_.emplace_back(kResultBatchSize * recordBytes);
+}
+
+/**
+ * @brief Slabs allocated by all pools so far.
+ *
+ * @return std::size_t The total.
+ */
+std::size_t ResultChannel::slabs_allocated() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::size_t total = 0;
+    for (const SlabPool& pool : pools_) {
+        total += pool.allocated();
+    }
+    return total;
+}
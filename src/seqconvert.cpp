@@ -0,0 +1,177 @@
+/**
+ * @file src/seqconvert.cpp
+ *
+ * @brief Convert NS1D0 result files between the text and binary formats.
+ *
+ * @section Overview
+ *
+ *   seqconvert to-binary <n> <in.txt> <out.bin> [--packed]
+ *   seqconvert to-text <in.bin> <out.txt>
+ *
+ * The text format does not record n, so it has to be given when converting to
+ * binary. The sequence length is taken from the first line, and every other
+ * line must match it.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../include/seqfile.h"
+
+/**
+ * @brief Print the command line usage.
+ *
+ * @param prog The program name.
+ *
+ * @return void
+ */
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " to-binary <n> <in.txt> <out.bin> [--packed]" << std::endl;
+    std::cerr << "       " << prog << " to-text <in.bin> <out.txt>" << std::endl;
+}
+
+/**
+ * @brief Convert a text result file into a binary one.
+ *
+ * @param n The modulus of the sequences.
+ * @param inPath The text file to read.
+ * @param outPath The binary file to write.
+ * @param format SeqFormat::Bytes or SeqFormat::Packed.
+ *
+ * @return int Exit status code.
+ */
+static int to_binary(int n, const char* inPath, const char* outPath, SeqFormat format) {
+    if (format == SeqFormat::Bytes && n > 256) {
+        std::cerr << "Error: the byte format needs n <= 256; use --packed." << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(inPath);
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open input file." << std::endl;
+        return 1;
+    }
+    std::ofstream out(outPath, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open output file." << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    std::vector<int> seq;
+    std::optional<SeqFileWriter> writer;   // created once the first line gives the length
+    std::size_t count = 0;
+    std::size_t lineNo = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty()) continue;
+        if (!parse_text_sequence(line.data(), line.data() + line.size(), seq)) {
+            std::cerr << "Error: line " << lineNo << " is not a sequence." << std::endl;
+            return 1;
+        }
+        if (!writer) {
+            writer.emplace(out, format, n, static_cast<int>(seq.size()));
+        }
+        if (static_cast<int>(seq.size()) != writer->length()) {
+            std::cerr << "Error: line " << lineNo << " has " << seq.size()
+                      << " elements, expected " << writer->length() << "." << std::endl;
+            return 1;
+        }
+        for (int v : seq) {
+            if (v >= n) {
+                std::cerr << "Error: line " << lineNo << " has a value >= n." << std::endl;
+                return 1;
+            }
+        }
+        writer->write(seq);
+        ++count;
+    }
+
+    if (!writer) {
+        // No sequences: still write a valid header
+        writer.emplace(out, format, n, (n - 1) / 2 + 1);
+    }
+    writer->flush();
+    if (writer->failed()) {
+        std::cerr << "Error: Could not write " << outPath << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Converted " << count << " sequences." << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Convert a binary result file into the text format.
+ *
+ * @param inPath The binary file to read.
+ * @param outPath The text file to write.
+ *
+ * @return int Exit status code.
+ */
+static int to_text(const char* inPath, const char* outPath) {
+    SeqFileReader reader;
+    std::string error;
+    if (!reader.open(inPath, error)) {
+        std::cerr << "Error: " << error << "." << std::endl;
+        return 1;
+    }
+    std::ofstream out(outPath);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open output file." << std::endl;
+        return 1;
+    }
+
+    SeqFileWriter writer(out, SeqFormat::Text, reader.n(), reader.length());
+    std::vector<int> seq(reader.length());
+    for (std::size_t i = 0; i < reader.count(); ++i) {
+        if (!reader.read(i, seq.data())) {
+            std::cerr << "Error: Record " << i + 1 << " of " << inPath << " has an element >= n = " << reader.n()
+                      << "." << std::endl;
+            return 1;
+        }
+        writer.write(seq);
+    }
+    writer.flush();
+    if (writer.failed()) {
+        std::cerr << "Error: Could not write " << outPath << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Converted " << reader.count() << " sequences." << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const std::string command = argv[1];
+
+    if (command == "to-binary" && (argc == 5 || argc == 6)) {
+        SeqFormat format = SeqFormat::Bytes;
+        if (argc == 6) {
+            if (std::string(argv[5]) != "--packed") {
+                print_usage(argv[0]);
+                return 1;
+            }
+            format = SeqFormat::Packed;
+        }
+        int n = std::atoi(argv[2]);
+        if (n <= 1 || (n % 2) != 1) {
+            std::cerr << "Error: n must be an odd integer greater than 1." << std::endl;
+            return 1;
+        }
+        return to_binary(n, argv[3], argv[4], format);
+    }
+    if (command == "to-text" && argc == 4) {
+        return to_text(argv[2], argv[3]);
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
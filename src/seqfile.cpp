@@ -0,0 +1,541 @@
+/**
+ * @file src/seqfile.cpp
+ *
+ * @brief Implementation of the result encoder, the buffered writer and the memory-mapped reader.
+ *
+ * @details See include/seqfile.h for the file layouts.
+ */
+
+#include "seqfile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[4] = {'N', 'S', '1', 'D'};
+static constexpr std::uint8_t kVersion = 1;
+
+/**
+ * @brief Store a 32-bit value little-endian.
+ */
+static void put_u32(unsigned char* p, std::uint32_t v) {
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+    p[2] = static_cast<unsigned char>(v >> 16);
+    p[3] = static_cast<unsigned char>(v >> 24);
+}
+
+/**
+ * @brief Load a little-endian 32-bit value.
+ */
+static std::uint32_t get_u32(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) |
+           (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) |
+           (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+/**
+ * @brief Number of bytes one record takes in a binary format.
+ */
+static std::size_t record_bytes(int length, int bits) {
+    return (static_cast<std::size_t>(length) * bits + 7) / 8;
+}
+
+/**
+ * @brief Number of bits a packed element needs for a given n.
+ *
+ * @param n The modulus.
+ *
+ * @return int ceil(log2 n), at least 1.
+ */
+int seqfile_bits_for(int n) {
+    int bits = 1;
+    while ((1 << bits) < n) {
+        ++bits;
+    }
+    return bits;
+}
+
+/**
+ * @brief Parse a format name ("text", "bytes" or "packed").
+ *
+ * @param name The name to parse.
+ * @param out Receives the format.
+ *
+ * @return true If the name is known.
+ */
+bool parse_seq_format(const std::string& name, SeqFormat& out) {
+    if (name == "text") {
+        out = SeqFormat::Text;
+    } else if (name == "bytes") {
+        out = SeqFormat::Bytes;
+    } else if (name == "packed") {
+        out = SeqFormat::Packed;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Name of a format, as accepted by parse_seq_format().
+ *
+ * @param format The format.
+ *
+ * @return const char* "text", "bytes" or "packed".
+ */
+const char* seq_format_name(SeqFormat format) {
+    switch (format) {
+        case SeqFormat::Bytes: return "bytes";
+        case SeqFormat::Packed: return "packed";
+        default: return "text";
+    }
+}
+
+/**
+ * @brief Parse one text line such as "0, 5, 2, 1" into integers.
+ *
+ * @param begin Start of the line (without the newline).
+ * @param end One past the end of the line.
+ * @param out Receives the elements; cleared first.
+ *
+ * @return true If the line is a non-empty list of non-negative integers.
+ *
+ * @details Hand-rolled rather than stream based so large files parse quickly.
+ */
+bool parse_text_sequence(const char* begin, const char* end, std::vector<int>& out) {
+    out.clear();
+    const char* p = begin;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\r')) ++p;
+        if (p == end) break;
+        if (*p < '0' || *p > '9') return false;
+
+        int v = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            const int digit = *p - '0';
+            if (v > (std::numeric_limits<int>::max() - digit) / 10) {
+                return false;   // does not fit in an int
+            }
+            v = v * 10 + digit;
+            ++p;
+        }
+        out.push_back(v);
+
+        while (p < end && (*p == ' ' || *p == '\r')) ++p;
+        if (p < end) {
+            if (*p != ',') return false;
+            ++p;
+        }
+    }
+    return !out.empty();
+}
+
+/**
+ * @brief Number of decimal digits of a non-negative value.
+ */
+static int decimal_digits(int v) {
+    int digits = 1;
+    while (v >= 10) {
+        v /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * @brief Create an encoder.
+ *
+ * @param format The layout to encode.
+ * @param n The modulus of the sequences.
+ * @param length The number of elements in every sequence.
+ */
+SeqEncoder::SeqEncoder(SeqFormat format, int n, int length)
+    : format_(format),
+      n_(n),
+      length_(length),
+      bits_(format == SeqFormat::Packed ? seqfile_bits_for(n) : 8) {
+    if (format_ == SeqFormat::Text) {
+        // Digits of the largest element, ", " between elements and the newline
+        maxBytes_ = static_cast<std::size_t>(length_) * (decimal_digits(std::max(0, n_ - 1)) + 2) + 1;
+    } else {
+        maxBytes_ = record_bytes(length_, bits_);
+    }
+}
+
+/**
+ * @brief The bytes taken by the first records of some encoded data.
+ *
+ * @param data Records as encode() wrote them.
+ * @param size Bytes in data.
+ * @param count Number of records wanted.
+ *
+ * @return std::size_t Bytes of the first count records, or size if data holds fewer.
+ *
+ * @details Binary records have a fixed size; text records end at their newline.
+ */
+std::size_t SeqEncoder::prefix_bytes(const char* data, std::size_t size, std::size_t count) const {
+    if (format_ != SeqFormat::Text) {
+        return std::min(size, count * maxBytes_);
+    }
+    std::size_t at = 0;
+    for (std::size_t i = 0; i < count && at < size; ++i) {
+        const void* newline = std::memchr(data + at, '\n', size - at);
+        if (!newline) {
+            return size;
+        }
+        at = static_cast<std::size_t>(static_cast<const char*>(newline) - data) + 1;
+    }
+    return at;
+}
+
+/**
+ * @brief Append the encoding of one sequence.
+ *
+ * @param seq The elements; exactly length() of them are read.
+ * @param out The buffer to append to.
+ *
+ * @return void
+ *
+ * @details Grows out by max_bytes() and shrinks it back to what was used, so
+ * a buffer that was reserved up front is never reallocated.
+ */
+void SeqEncoder::encode(const int* seq, std::vector<char>& out) const {
+    const std::size_t start = out.size();
+    out.resize(start + maxBytes_);
+    char* p = out.data() + start;
+
+    if (format_ == SeqFormat::Text) {
+        char* const end = out.data() + out.size();
+        for (int i = 0; i < length_; ++i) {
+            p = std::to_chars(p, end, seq[i]).ptr;
+            if (i + 1 < length_) {
+                *p++ = ',';
+                *p++ = ' ';
+            }
+        }
+        *p++ = '\n';
+        out.resize(static_cast<std::size_t>(p - out.data()));
+        return;
+    }
+
+    if (format_ == SeqFormat::Bytes) {
+        for (int i = 0; i < length_; ++i) {
+            p[i] = static_cast<char>(seq[i]);
+        }
+        return;
+    }
+
+    // Least significant bit first: shift each element in above the pending bits, emit whole bytes
+    const std::uint64_t mask = (std::uint64_t{1} << bits_) - 1;
+    std::uint64_t pending = 0;
+    int pendingBits = 0;
+    for (int i = 0; i < length_; ++i) {
+        pending |= (static_cast<std::uint64_t>(seq[i]) & mask) << pendingBits;
+        pendingBits += bits_;
+        while (pendingBits >= 8) {
+            *p++ = static_cast<char>(pending);
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+    if (pendingBits > 0) {
+        *p = static_cast<char>(pending);
+    }
+}
+
+/**
+ * @brief Create a writer and, for the binary formats, write the file header.
+ *
+ * @param out The stream to write to.
+ * @param format The layout to use.
+ * @param n The modulus of the sequences.
+ * @param length The number of elements in every sequence.
+ * @param writeHeader False when appending to a file that already has its header.
+ */
+SeqFileWriter::SeqFileWriter(std::ostream& out, SeqFormat format, int n, int length, bool writeHeader)
+    : out_(out),
+      encoder_(format, n, length) {
+    buffer_.reserve(kBufferBytes);
+    if (format == SeqFormat::Text || !writeHeader) {
+        return;
+    }
+
+    unsigned char header[kSeqFileHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    header[4] = kVersion;
+    header[5] = static_cast<unsigned char>(format);
+    header[6] = static_cast<unsigned char>(encoder_.bits());
+    put_u32(header + 8, static_cast<std::uint32_t>(n));
+    put_u32(header + 12, static_cast<std::uint32_t>(length));
+    buffer_.insert(buffer_.end(), header, header + sizeof(header));
+}
+
+SeqFileWriter::~SeqFileWriter() {
+    flush();
+}
+
+/**
+ * @brief Write one sequence.
+ *
+ * @param seq The elements; exactly length() of them are read.
+ *
+ * @return void
+ */
+void SeqFileWriter::write(const int* seq) {
+    if (buffer_.size() + encoder_.max_bytes() > kBufferBytes) {
+        drain();
+    }
+    encoder_.encode(seq, buffer_);
+}
+
+/**
+ * @brief Write records produced by a SeqEncoder with the same format, n and length.
+ *
+ * @param data The encoded records.
+ * @param size Number of bytes.
+ *
+ * @return void
+ *
+ * @details Blocks larger than the buffer go to the stream directly, after what is
+ * already buffered.
+ */
+void SeqFileWriter::write_encoded(const char* data, std::size_t size) {
+    if (buffer_.size() + size > kBufferBytes) {
+        drain();
+        if (size >= kBufferBytes) {
+            if (!failed_) {
+                out_.write(data, static_cast<std::streamsize>(size));
+                failed_ = !out_;
+            }
+            return;
+        }
+    }
+    buffer_.insert(buffer_.end(), data, data + size);
+}
+
+/**
+ * @brief Hand everything buffered to the stream and flush the stream.
+ *
+ * @return void
+ */
+void SeqFileWriter::flush() {
+    drain();
+    if (!failed_) {
+        out_.flush();
+        failed_ = !out_;
+    }
+}
+
+/**
+ * @brief Pass the buffer to the stream in one write.
+ *
+ * @return void
+ *
+ * @details After a failed write the buffer is discarded instead.
+ */
+void SeqFileWriter::drain() {
+    if (!buffer_.empty()) {
+        if (!failed_) {
+            out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            failed_ = !out_;
+        }
+        buffer_.clear();
+    }
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Map a whole file read-only.
+ *
+ * @param path The file to map.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was mapped.
+ */
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "could not open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        error = "could not read the size of " + path;
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        error = "could not map " + path;
+        return false;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(map);
+    size_ = size;
+    return true;
+}
+
+/**
+ * @brief Unmap the file, if one is mapped.
+ *
+ * @return void
+ */
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+SeqFileReader::~SeqFileReader() {
+    close();
+}
+
+/**
+ * @brief Map a binary result file and validate its header.
+ *
+ * @param path The file to open.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was mapped and its header is valid.
+ */
+bool SeqFileReader::open(const std::string& path, std::string& error) {
+    close();
+    if (!file_.open(path, error)) {
+        return false;
+    }
+    if (!open(file_, path, error)) {
+        file_.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Validate the header of a binary result file that is already mapped.
+ *
+ * @param file The mapping; it must stay open as long as the reader is used.
+ * @param path The file's name, for error messages.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the header is valid.
+ */
+bool SeqFileReader::open(const MappedFile& file, const std::string& path, std::string& error) {
+    data_ = nullptr;
+    count_ = 0;
+    if (file.size() < kSeqFileHeaderSize) {
+        error = path + " is too small to be a binary result file";
+        return false;
+    }
+    const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(file.data());
+
+    const std::uint8_t format = data[5];
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || data[4] != kVersion ||
+        (format != static_cast<std::uint8_t>(SeqFormat::Bytes) &&
+         format != static_cast<std::uint8_t>(SeqFormat::Packed))) {
+        error = path + " is not a binary result file";
+        return false;
+    }
+
+    format_ = static_cast<SeqFormat>(format);
+    bits_ = data[6];
+    const std::uint32_t n = get_u32(data + 8);
+    const std::uint32_t length = get_u32(data + 12);
+    if (bits_ <= 0 || bits_ > 31) {
+        error = path + " has a corrupt header";
+        return false;
+    }
+    // The writer only stores odd n >= 3, and bytes hold elements below 256
+    const std::uint32_t maxN = format_ == SeqFormat::Bytes ? 256 : std::uint32_t{1} << 30;
+    if (n < 3 || n % 2 != 1 || n > maxN) {
+        error = path + " has an invalid n (" + std::to_string(n) + ") in its header";
+        return false;
+    }
+    n_ = static_cast<int>(n);
+    const int bits = format_ == SeqFormat::Packed ? seqfile_bits_for(n_) : 8;
+    if (bits_ != bits) {
+        error = path + " stores " + std::to_string(bits_) + " bits per element, but n = " + std::to_string(n) +
+                " needs " + std::to_string(bits);
+        return false;
+    }
+    if (length != n / 2 + 1) {
+        error = path + " stores sequences of length " + std::to_string(length) + ", but n = " +
+                std::to_string(n) + " needs " + std::to_string(n / 2 + 1);
+        return false;
+    }
+    length_ = static_cast<int>(length);
+    recordBytes_ = ::record_bytes(length_, bits_);
+
+    const std::size_t body = file.size() - kSeqFileHeaderSize;
+    if (body % recordBytes_ != 0) {
+        error = path + " has a truncated record";
+        return false;
+    }
+    data_ = data;
+    size_ = file.size();
+    count_ = body / recordBytes_;
+    return true;
+}
+
+/**
+ * @brief Forget the file, unmapping it if the reader mapped it itself.
+ *
+ * @return void
+ */
+void SeqFileReader::close() {
+    file_.close();
+    data_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+}
+
+/**
+ * @brief Decode one sequence.
+ *
+ * @param i The index of the sequence.
+ * @param out Receives length() elements.
+ *
+ * @return true If every element is below n; false if the record is corrupt.
+ */
+bool SeqFileReader::read(std::size_t i, int* out) const {
+    const std::uint8_t* rec = raw(i);
+    bool inRange = true;
+    if (format_ == SeqFormat::Bytes) {
+        for (int k = 0; k < length_; ++k) {
+            out[k] = rec[k];
+            inRange = inRange && out[k] < n_;
+        }
+        return inRange;
+    }
+
+    std::size_t bit = 0;
+    for (int k = 0; k < length_; ++k) {
+        int v = 0;
+        for (int b = 0; b < bits_; ++b, ++bit) {
+            v |= ((rec[bit >> 3] >> (bit & 7)) & 1) << b;
+        }
+        out[k] = v;
+        inRange = inRange && v < n_;
+    }
+    return inRange;
+}
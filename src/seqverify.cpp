@@ -0,0 +1,483 @@
+/**
+ * @file src/seqverify.cpp
+ *
+ * @brief Check an NS1D0 result file against the rules without re-running the search.
+ *
+ * @section Overview
+ *
+ *   seqverify <file> [--n n] [--expect count] [--threads t]
+ *
+ * The file is memory-mapped and cut into chunks: line-aligned byte ranges for
+ * the text format, record ranges for the binary ones. The threads take chunks
+ * one at a time and check every sequence with is_valid_prefix(), the reference
+ * implementation of the rules, at the full length. Valid sequences are hashed
+ * into one of kBuckets buckets per thread by the top bits of their hash.
+ *
+ * The duplicate pass then hands out whole buckets: a thread gathers one bucket
+ * from every thread, sorts it by hash, and compares the sequences behind equal
+ * hashes element by element, so a hash collision is never mistaken for a
+ * duplicate. It keeps 16 bytes per sequence in memory.
+ *
+ * A binary file records n in its header. A text file does not, so n is taken
+ * from the length of the first sequence (NS1D0(n) sequences have (n + 1) / 2
+ * elements) unless --n gives it. With --expect the number of sequences must
+ * also match a known total. The exit status is 0 only if every check passed.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/ns1d0.h"
+#include "../include/ns1d0_api.h"
+#include "../include/seqfile.h"
+
+/**
+ * @brief Chunks per thread the file is cut into, so a slow chunk does not hold up the others.
+ */
+static constexpr std::size_t kChunksPerThread = 8;
+
+/**
+ * @brief Buckets the hashes are spread over; the duplicate pass hands out one bucket at a time.
+ */
+static constexpr int kBucketBits = 8;
+static constexpr std::size_t kBuckets = std::size_t{1} << kBucketBits;
+
+/**
+ * @brief Invalid sequences and duplicates listed by name; the rest are only counted.
+ */
+static constexpr std::size_t kMaxReported = 10;
+
+/**
+ * @struct HashedRecord
+ *
+ * @brief A valid sequence as the duplicate pass sees it.
+ *
+ * @var hash Hash of the elements.
+ * @var pos Where the sequence is: its line's byte offset in a text file, its index in a binary one.
+ */
+struct HashedRecord {
+    std::uint64_t hash;
+    std::uint64_t pos;
+
+    bool operator <(const HashedRecord& other) const {
+        return hash != other.hash ? hash < other.hash : pos < other.pos;
+    }
+};
+
+/**
+ * @struct ThreadResult
+ *
+ * @brief What one thread found, in the check pass and then in the duplicate pass.
+ *
+ * @var sequences Sequences read.
+ * @var invalid Sequences that break a rule or could not be parsed.
+ * @var invalidAt Positions of the first kMaxReported invalid sequences.
+ * @var buckets Valid sequences, by the top bits of their hash.
+ * @var duplicates Sequences equal to one earlier in the file.
+ * @var duplicateAt The first kMaxReported duplicates, with the position of the earlier copy.
+ */
+struct ThreadResult {
+    std::size_t sequences = 0;
+    std::size_t invalid = 0;
+    std::vector<std::uint64_t> invalidAt;
+    std::vector<std::vector<HashedRecord>> buckets = std::vector<std::vector<HashedRecord>>(kBuckets);
+    std::size_t duplicates = 0;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> duplicateAt;
+};
+
+/**
+ * @class ResultFile
+ *
+ * @brief A mapped result file of any format, read by position.
+ */
+class ResultFile {
+    public:
+        // Map the file and work out its format; a file that is not binary is read as text.
+        bool open(const std::string& path, std::string& error) {
+            if (!file_.open(path, error)) {
+                return false;
+            }
+            binary_ = file_.size() >= kSeqFileHeaderSize && std::memcmp(file_.data(), "NS1D", 4) == 0;
+            if (binary_ && !reader_.open(file_, path, error)) {
+                return false;
+            }
+            return true;
+        }
+
+        bool binary() const { return binary_; }
+        SeqFormat format() const { return binary_ ? reader_.format() : SeqFormat::Text; }
+        const char* data() const { return file_.data(); }
+        std::size_t size() const { return file_.size(); }
+        const SeqFileReader& reader() const { return reader_; }
+
+        // Decode the sequence at pos; false if a text line is not a list of integers, or a record has an element >= n.
+        bool decode(std::uint64_t pos, std::vector<int>& out) const {
+            if (binary_) {
+                out.resize(reader_.length());
+                return reader_.read(pos, out.data());
+            }
+            const char* begin = file_.data() + pos;
+            return parse_text_sequence(begin, line_end(begin), out);
+        }
+
+        // End of the line starting at begin, without its newline.
+        const char* line_end(const char* begin) const {
+            const char* end = file_.data() + file_.size();
+            const void* newline = std::memchr(begin, '\n', static_cast<std::size_t>(end - begin));
+            return newline ? static_cast<const char*>(newline) : end;
+        }
+
+    private:
+        MappedFile file_;
+        SeqFileReader reader_;
+        bool binary_ = false;
+};
+
+/**
+ * @brief Print the command line usage.
+ *
+ * @param prog The program name.
+ *
+ * @return void
+ */
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <file> [--n n] [--expect count] [--threads t]" << std::endl;
+}
+
+/**
+ * @brief Hash of a sequence: FNV-1a over the elements, then mixed so the top bits are as good as the rest.
+ */
+static std::uint64_t hash_sequence(const std::vector<int>& seq) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (int v : seq) {
+        hash ^= static_cast<std::uint32_t>(v);
+        hash *= 1099511628211ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * @brief The chunks of the file: line-aligned byte ranges of a text file, record ranges of a binary one.
+ *
+ * @param file The file.
+ * @param chunks How many chunks to aim for.
+ *
+ * @return std::vector<std::pair<std::uint64_t, std::uint64_t>> The [begin, end) ranges, in file order.
+ */
+static std::vector<std::pair<std::uint64_t, std::uint64_t>> split_file(const ResultFile& file, std::size_t chunks) {
+    const std::uint64_t total = file.binary() ? file.reader().count() : file.size();
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+    std::uint64_t begin = 0;
+    for (std::size_t i = 1; i <= chunks && begin < total; ++i) {
+        std::uint64_t end = total * i / chunks;
+        if (!file.binary() && end > begin && end < total) {
+            // Move the cut to just past the next newline, so no line is split
+            end = static_cast<std::uint64_t>(file.line_end(file.data() + end - 1) - file.data()) + 1;
+            end = std::min(end, total);
+        }
+        if (end > begin) {
+            ranges.emplace_back(begin, end);
+            begin = end;
+        }
+    }
+    return ranges;
+}
+
+/**
+ * @brief Check one sequence and, if it is valid, add it to the thread's buckets.
+ *
+ * @return void
+ */
+static void check_sequence(bool parsed, const std::vector<int>& seq, std::uint64_t pos,
+                           const NS1D0Config& cfg, ThreadResult& result) {
+    ++result.sequences;
+    if (!parsed || static_cast<int>(seq.size()) != cfg.targetLength || !is_valid_prefix(seq, cfg)) {
+        if (result.invalid++ < kMaxReported) {
+            result.invalidAt.push_back(pos);
+        }
+        return;
+    }
+    const std::uint64_t hash = hash_sequence(seq);
+    result.buckets[hash >> (64 - kBucketBits)].push_back({hash, pos});
+}
+
+/**
+ * @brief Check every sequence in one chunk.
+ *
+ * @param file The file.
+ * @param range The chunk, as made by split_file().
+ * @param cfg Configuration of the n the file is for.
+ * @param result The calling thread's result.
+ *
+ * @return void
+ *
+ * @details Empty lines of a text file are skipped, as seqconvert and shardmerge skip them.
+ */
+static void check_chunk(const ResultFile& file, std::pair<std::uint64_t, std::uint64_t> range,
+                        const NS1D0Config& cfg, ThreadResult& result) {
+    std::vector<int> seq;
+    seq.reserve(cfg.targetLength);
+    if (file.binary()) {
+        for (std::uint64_t i = range.first; i < range.second; ++i) {
+            check_sequence(file.decode(i, seq), seq, i, cfg, result);
+        }
+        return;
+    }
+
+    const char* p = file.data() + range.first;
+    const char* end = file.data() + range.second;
+    while (p < end) {
+        const char* lineEnd = file.line_end(p);
+        if (lineEnd > p) {
+            const bool parsed = parse_text_sequence(p, lineEnd, seq);
+            check_sequence(parsed, seq, static_cast<std::uint64_t>(p - file.data()), cfg, result);
+        }
+        p = lineEnd + 1;
+    }
+}
+
+/**
+ * @brief Find the duplicates in one bucket.
+ *
+ * @param bucket The bucket's index.
+ * @param file The file.
+ * @param results Every thread's result; bucket is read from all of them.
+ * @param scratch The calling thread's buffer for the gathered bucket.
+ * @param result The calling thread's result.
+ *
+ * @return void
+ *
+ * @details Sequences with equal hashes are compared in full, each against the
+ * earlier ones with the same hash, so every copy after the first counts once.
+ */
+static void find_duplicates(std::size_t bucket, const ResultFile& file, std::vector<ThreadResult>& results,
+                            std::vector<HashedRecord>& scratch, ThreadResult& result) {
+    scratch.clear();
+    for (ThreadResult& r : results) {
+        scratch.insert(scratch.end(), r.buckets[bucket].begin(), r.buckets[bucket].end());
+        std::vector<HashedRecord>().swap(r.buckets[bucket]);
+    }
+    std::sort(scratch.begin(), scratch.end());
+
+    std::vector<int> a;
+    std::vector<int> b;
+    for (std::size_t first = 0; first < scratch.size();) {
+        std::size_t last = first + 1;
+        while (last < scratch.size() && scratch[last].hash == scratch[first].hash) {
+            ++last;
+        }
+        for (std::size_t i = first + 1; i < last; ++i) {
+            file.decode(scratch[i].pos, a);
+            for (std::size_t j = first; j < i; ++j) {
+                file.decode(scratch[j].pos, b);
+                if (a == b) {
+                    if (result.duplicates++ < kMaxReported) {
+                        result.duplicateAt.emplace_back(scratch[i].pos, scratch[j].pos);
+                    }
+                    break;
+                }
+            }
+        }
+        first = last;
+    }
+}
+
+/**
+ * @brief Run a function on t threads, each calling it with its index until it returns false.
+ *
+ * @return void
+ */
+template <typename Work>
+static void run_threads(int threads, Work work) {
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            while (work(t)) {
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Where a sequence is, for the user: "line L" of a text file, "record i" of a binary one.
+ *
+ * @param file The file.
+ * @param pos The sequence's position, as in HashedRecord.
+ *
+ * @return std::string The description, followed by the sequence itself.
+ */
+static std::string describe(const ResultFile& file, std::uint64_t pos) {
+    std::string where;
+    std::string text;
+    if (file.binary()) {
+        where = "record " + std::to_string(pos);
+        std::vector<int> seq;
+        file.decode(pos, seq);
+        for (std::size_t i = 0; i < seq.size(); ++i) {
+            text += (i ? ", " : "") + std::to_string(seq[i]);
+        }
+    } else {
+        const char* begin = file.data() + pos;
+        const std::size_t line = 1 + static_cast<std::size_t>(std::count(file.data(), begin, '\n'));
+        where = "line " + std::to_string(line);
+        text.assign(begin, file.line_end(begin));
+    }
+    return where + ": " + text;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    int n = 0;
+    long long expect = -1;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--n" && i + 1 < argc) {
+            n = std::atoi(argv[++i]);
+        } else if (arg == "--expect" && i + 1 < argc) {
+            expect = std::atoll(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0 || !path.empty()) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            path = arg;
+        }
+    }
+    if (path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    ResultFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::cerr << "Error: " << error << "." << std::endl;
+        return 1;
+    }
+
+    if (file.binary()) {
+        if (n != 0 && n != file.reader().n()) {
+            std::cerr << "Error: " << path << " holds sequences for n = " << file.reader().n() << "." << std::endl;
+            return 1;
+        }
+        n = file.reader().n();
+    } else if (n == 0) {
+        // The length of the first sequence gives n
+        std::vector<int> first;
+        for (const char* p = file.data(), *end = p + file.size(); p < end && n == 0;) {
+            const char* lineEnd = file.line_end(p);
+            if (lineEnd > p && parse_text_sequence(p, lineEnd, first)) {
+                n = 2 * static_cast<int>(first.size()) - 1;
+            }
+            p = lineEnd + 1;
+        }
+    }
+
+    std::vector<ThreadResult> results(threads);
+    if (file.size() > 0 && n == 0) {
+        std::cerr << "Error: " << path << " has no sequence to take n from; give it with --n." << std::endl;
+        return 1;
+    }
+    if (n != 0 && (n <= 1 || n % 2 != 1)) {
+        std::cerr << "Error: n must be an odd integer greater than 1." << std::endl;
+        return 1;
+    }
+
+    double checkSeconds = 0.0;
+    if (n != 0) {
+        const NS1D0Config cfg = ns1d0_config(n);
+        const auto chunks = split_file(file, kChunksPerThread * static_cast<std::size_t>(threads));
+        std::atomic<std::size_t> nextChunk{0};
+        run_threads(threads, [&](int t) {
+            const std::size_t c = nextChunk.fetch_add(1);
+            if (c >= chunks.size()) {
+                return false;
+            }
+            check_chunk(file, chunks[c], cfg, results[t]);
+            return true;
+        });
+        checkSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::atomic<std::size_t> nextBucket{0};
+        std::vector<std::vector<HashedRecord>> scratch(threads);
+        run_threads(threads, [&](int t) {
+            const std::size_t bucket = nextBucket.fetch_add(1);
+            if (bucket >= kBuckets) {
+                return false;
+            }
+            find_duplicates(bucket, file, results, scratch[t], results[t]);
+            return true;
+        });
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t sequences = 0;
+    std::size_t invalid = 0;
+    std::size_t duplicates = 0;
+    std::vector<std::uint64_t> invalidAt;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> duplicateAt;
+    for (const ThreadResult& r : results) {
+        sequences += r.sequences;
+        invalid += r.invalid;
+        duplicates += r.duplicates;
+        invalidAt.insert(invalidAt.end(), r.invalidAt.begin(), r.invalidAt.end());
+        duplicateAt.insert(duplicateAt.end(), r.duplicateAt.begin(), r.duplicateAt.end());
+    }
+    std::sort(invalidAt.begin(), invalidAt.end());
+    std::sort(duplicateAt.begin(), duplicateAt.end());
+    invalidAt.resize(std::min(invalidAt.size(), kMaxReported));
+    duplicateAt.resize(std::min(duplicateAt.size(), kMaxReported));
+
+    std::cout << path << ": " << seq_format_name(file.format());
+    if (n != 0) {
+        std::cout << ", NS1D0(" << n << ")";
+    }
+    std::cout << std::endl;
+    std::cout << "Sequences: " << sequences << std::endl;
+    std::cout << "Invalid sequences: " << invalid << std::endl;
+    for (std::uint64_t pos : invalidAt) {
+        std::cout << "  " << describe(file, pos) << std::endl;
+    }
+    std::cout << "Duplicate sequences: " << duplicates << std::endl;
+    for (const auto& [pos, earlier] : duplicateAt) {
+        std::cout << "  " << describe(file, pos) << " (same as " << describe(file, earlier) << ")" << std::endl;
+    }
+
+    bool ok = invalid == 0 && duplicates == 0;
+    if (expect >= 0) {
+        const bool match = sequences == static_cast<std::size_t>(expect);
+        std::cout << "Expected sequences: " << expect << (match ? " (match)" : " (MISMATCH)") << std::endl;
+        ok = ok && match;
+    }
+
+    const double megabytes = static_cast<double>(file.size()) / (1024.0 * 1024.0);
+    std::cout << std::fixed << std::setprecision(3)
+              << "Checked " << megabytes << " MiB in " << seconds << " s on " << threads << " threads ("
+              << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MiB/s; rules " << checkSeconds
+              << " s, duplicates " << seconds - checkSeconds << " s)" << std::endl;
+    std::cout << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file src/shard.cpp
+ *
+ * @brief Implementation of the shard split and of shard manifests.
+ */
+
+#include "shard.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+static const char* const kManifestMagic = "NS1D0-SHARD";
+static constexpr int kManifestVersion = 1;
+
+/**
+ * @brief Parse a shard spec of the form "i/k" with 0 <= i < k.
+ *
+ * @param text The text to parse.
+ * @param out Receives the spec.
+ *
+ * @return true If the text is a valid spec.
+ */
+bool parse_shard_spec(const std::string& text, ShardSpec& out) {
+    const std::size_t slash = text.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 == text.size()) {
+        return false;
+    }
+    char* end = nullptr;
+    const long index = std::strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() + slash) {
+        return false;
+    }
+    const long count = std::strtol(text.c_str() + slash + 1, &end, 10);
+    if (*end != '\0' || count < 1 || index < 0 || index >= count || count > 1 << 20) {
+        return false;
+    }
+    out.index = static_cast<int>(index);
+    out.count = static_cast<int>(count);
+    return true;
+}
+
+/**
+ * @brief Append the valid extensions of the state's prefix to the given length to out.
+ */
+static void collect_prefixes(SearchState& state, int length, std::vector<std::vector<int>>& out) {
+    if (state.size() == length) {
+        out.push_back(state.sequence());
+        return;
+    }
+    SearchState::Candidates candidates = state.candidates(0);
+    int v;
+    while (candidates.next(v)) {
+        state.push(v);
+        collect_prefixes(state, length, out);
+        state.pop();
+    }
+}
+
+/**
+ * @brief Every valid prefix of the given length, in lexicographic order.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param length The prefix length, at most cfg.targetLength.
+ *
+ * @return std::vector<std::vector<int>> The prefixes.
+ *
+ * @details Only Rules 1-6 decide what a prefix is; neither the lookahead nor symmetry
+ * breaking, so the split does not depend on the search options.
+ */
+std::vector<std::vector<int>> valid_prefixes(const NS1D0Config& cfg, int length) {
+    std::vector<std::vector<int>> prefixes;
+    SearchState state(cfg);
+    collect_prefixes(state, length, prefixes);
+    return prefixes;
+}
+
+/**
+ * @brief The prefix length a run with shardCount shards is split at.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param shardCount Number of shards.
+ *
+ * @return int The shortest length from 2 up with at least kPrefixesPerShard prefixes per shard,
+ * but no longer than the sequences allow.
+ *
+ * @details Stops one short of the sequence length, so every prefix still has a subtree to
+ * search, unless the sequences are too short for that.
+ */
+int shard_depth(const NS1D0Config& cfg, int shardCount) {
+    const int maxDepth = std::max(2, cfg.targetLength - 1);
+    const std::size_t wanted = kPrefixesPerShard * static_cast<std::size_t>(shardCount);
+    int depth = 2;
+    while (depth < maxDepth && valid_prefixes(cfg, depth).size() < wanted) {
+        ++depth;
+    }
+    return depth;
+}
+
+/**
+ * @brief The shard a prefix belongs to: a 64-bit FNV-1a hash of its elements modulo the shard count.
+ *
+ * @param prefix The prefix.
+ * @param shardCount Number of shards.
+ *
+ * @return int The shard index.
+ */
+int shard_of(const std::vector<int>& prefix, int shardCount) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (int v : prefix) {
+        for (int byte = 0; byte < 4; ++byte) {
+            hash ^= (static_cast<std::uint32_t>(v) >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return static_cast<int>(hash % static_cast<std::uint64_t>(shardCount));
+}
+
+/**
+ * @brief The prefixes a shard searches.
+ *
+ * @param cfg Configuration containing the target length and other parameters.
+ * @param spec The shard.
+ * @param depth Receives the prefix length, see shard_depth().
+ *
+ * @return std::vector<std::vector<int>> The prefixes, in lexicographic order.
+ */
+std::vector<std::vector<int>> shard_prefixes(const NS1D0Config& cfg, const ShardSpec& spec, int& depth) {
+    depth = shard_depth(cfg, spec.count);
+    std::vector<std::vector<int>> mine;
+    for (std::vector<int>& prefix : valid_prefixes(cfg, depth)) {
+        if (shard_of(prefix, spec.count) == spec.index) {
+            mine.push_back(std::move(prefix));
+        }
+    }
+    return mine;
+}
+
+/**
+ * @brief The search task that covers exactly the subtree below a prefix.
+ *
+ * @param prefix A valid prefix of length 2 or more.
+ *
+ * @return SearchTask The task: the prefix without its last element, with that element as the only candidate.
+ */
+SearchTask prefix_task(const std::vector<int>& prefix) {
+    const int last = prefix.back();
+    return SearchTask{std::vector<int>(prefix.begin(), prefix.end() - 1), last, last + 1};
+}
+
+/**
+ * @brief Write a shard manifest.
+ *
+ * @param path The manifest file.
+ * @param m The manifest to write.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was written.
+ */
+bool save_shard_manifest(const std::string& path, const ShardManifest& m, std::string& error) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        error = "could not create " + path;
+        return false;
+    }
+
+    out << kManifestMagic << ' ' << kManifestVersion << '\n';
+    out << "n " << m.n << '\n';
+    out << "shard " << m.shard.index << ' ' << m.shard.count << '\n';
+    out << "depth " << m.depth << '\n';
+    out << "symmetry " << (m.symmetry ? 1 : 0) << '\n';
+    out << "count_only " << (m.countOnly ? 1 : 0) << '\n';
+    out << "format " << seq_format_name(m.format) << '\n';
+    out << "output " << (m.output.empty() ? "-" : m.output) << '\n';
+    out << "sequences " << m.sequences << '\n';
+    out << "nodes " << m.nodes << '\n';
+    out << "prefixes " << m.prefixes.size() << '\n';
+    for (const std::vector<int>& prefix : m.prefixes) {
+        for (std::size_t i = 0; i < prefix.size(); ++i) {
+            out << (i ? " " : "") << prefix[i];
+        }
+        out << '\n';
+    }
+
+    out.flush();
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read a shard manifest.
+ *
+ * @param path The manifest file.
+ * @param m Receives the manifest.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was read and is well formed.
+ */
+bool load_shard_manifest(const std::string& path, ShardManifest& m, std::string& error) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    // Read "<key> <value>" and check the key
+    auto expect = [&](const char* key) {
+        std::string word;
+        in >> word;
+        return static_cast<bool>(in) && word == key;
+    };
+
+    std::string magic;
+    int version = 0;
+    in >> magic >> version;
+    if (!in || magic != kManifestMagic || version != kManifestVersion) {
+        error = path + " is not a shard manifest";
+        return false;
+    }
+
+    int symmetry = 0;
+    int countOnly = 0;
+    std::string format;
+    std::size_t prefixCount = 0;
+
+    bool ok = expect("n") && (in >> m.n) &&
+              expect("shard") && (in >> m.shard.index >> m.shard.count) &&
+              expect("depth") && (in >> m.depth) &&
+              expect("symmetry") && (in >> symmetry) &&
+              expect("count_only") && (in >> countOnly) &&
+              expect("format") && (in >> format) &&
+              expect("output") && std::getline(in >> std::ws, m.output) &&
+              expect("sequences") && (in >> m.sequences) &&
+              expect("nodes") && (in >> m.nodes) &&
+              expect("prefixes") && (in >> prefixCount);
+    ok = ok && parse_seq_format(format, m.format) && m.depth >= 1;
+
+    m.prefixes.assign(ok ? prefixCount : 0, std::vector<int>(ok ? m.depth : 0));
+    for (std::size_t i = 0; ok && i < prefixCount; ++i) {
+        for (int& v : m.prefixes[i]) {
+            ok = ok && static_cast<bool>(in >> v);
+        }
+    }
+
+    if (!ok) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+    if (m.output == "-") {
+        m.output.clear();
+    }
+    m.symmetry = symmetry != 0;
+    m.countOnly = countOnly != 0;
+    return true;
+}
@@ -0,0 +1,302 @@
+/**
+ * @file src/shardmerge.cpp
+ *
+ * @brief Check that the shards of a sharded run cover the search exactly, and merge their results.
+ *
+ * @section Overview
+ *
+ *   shardmerge <manifest>... [--output <file>]
+ *
+ * The manifests must come from one run: the same n, shard count, split depth and
+ * options, and every shard index exactly once. Every valid prefix at the split
+ * depth must be listed by exactly one manifest, the one it hashes to. The output
+ * file of every shard is read back and must hold as many sequences as its
+ * manifest says. With --output the shard files are concatenated, in shard order,
+ * into one file of the same format.
+ *
+ * An output file is looked for under the name in its manifest and, failing that,
+ * next to the manifest, so shards gathered from several machines into one
+ * directory can be merged as they are.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../include/shard.h"
+#include "../include/seqfile.h"
+#include "../include/ns1d0_api.h"
+
+/**
+ * @brief Print the command line usage.
+ *
+ * @param prog The program name.
+ *
+ * @return void
+ */
+static void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <manifest>... [--output <file>]" << std::endl;
+}
+
+/**
+ * @brief Where a shard's output file is: as named in the manifest, or else next to the manifest.
+ *
+ * @param manifestPath The manifest file.
+ * @param output The output file named in the manifest.
+ *
+ * @return std::string The path to open.
+ */
+static std::string resolve_output(const std::string& manifestPath, const std::string& output) {
+    if (std::ifstream(output).good()) {
+        return output;
+    }
+    const std::size_t manifestSlash = manifestPath.rfind('/');
+    const std::size_t outputSlash = output.rfind('/');
+    const std::string dir = manifestSlash == std::string::npos ? "" : manifestPath.substr(0, manifestSlash + 1);
+    return dir + (outputSlash == std::string::npos ? output : output.substr(outputSlash + 1));
+}
+
+/**
+ * @brief Count the sequences in a result file.
+ *
+ * @param path The file.
+ * @param m The manifest of the shard that wrote it.
+ * @param count Receives the number of sequences.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file could be read and matches the manifest's n.
+ */
+static bool count_sequences(const std::string& path, const ShardManifest& m, std::size_t& count, std::string& error) {
+    if (m.format != SeqFormat::Text) {
+        SeqFileReader reader;
+        if (!reader.open(path, error)) {
+            return false;
+        }
+        if (reader.n() != m.n) {
+            error = path + " holds sequences for n = " + std::to_string(reader.n());
+            return false;
+        }
+        count = reader.count();
+        return true;
+    }
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "could not open " + path;
+        return false;
+    }
+    count = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) ++count;
+    }
+    return true;
+}
+
+/**
+ * @brief Append a shard's result file to the merged output.
+ *
+ * @param path The shard's result file.
+ * @param format The format of both files.
+ * @param out The merged output.
+ * @param writer Writer of the merged output for the binary formats; created from the first file.
+ * @param error Receives a description of the problem on failure.
+ *
+ * @return true If the file was appended.
+ */
+static bool append_file(const std::string& path,
+                        SeqFormat format,
+                        std::ofstream& out,
+                        std::optional<SeqFileWriter>& writer,
+                        std::string& error) {
+    if (format == SeqFormat::Text) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            error = "could not open " + path;
+            return false;
+        }
+        if (in.peek() != std::ifstream::traits_type::eof()) {
+            out << in.rdbuf();
+        }
+        return true;
+    }
+
+    SeqFileReader reader;
+    if (!reader.open(path, error)) {
+        return false;
+    }
+    if (!writer) {
+        writer.emplace(out, format, reader.n(), reader.length());
+    }
+    std::vector<int> seq(reader.length());
+    for (std::size_t i = 0; i < reader.count(); ++i) {
+        if (!reader.read(i, seq.data())) {
+            error = "record " + std::to_string(i + 1) + " of " + path + " has an element >= n";
+            return false;
+        }
+        writer->write(seq);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Load the manifests and check they describe one run
+    std::vector<ShardManifest> manifests(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        std::string error;
+        if (!load_shard_manifest(paths[i], manifests[i], error)) {
+            std::cerr << "Error: " << error << "." << std::endl;
+            return 1;
+        }
+        const ShardManifest& a = manifests[0];
+        const ShardManifest& b = manifests[i];
+        if (b.n != a.n || b.shard.count != a.shard.count || b.depth != a.depth ||
+            b.symmetry != a.symmetry || b.countOnly != a.countOnly || b.format != a.format) {
+            std::cerr << "Error: " << paths[i] << " belongs to a different run than " << paths[0] << "." << std::endl;
+            return 1;
+        }
+    }
+    const ShardManifest& run = manifests[0];
+    const int shardCount = run.shard.count;
+
+    std::vector<int> manifestOf(shardCount, -1);   // manifest index per shard
+    for (std::size_t i = 0; i < manifests.size(); ++i) {
+        const int shard = manifests[i].shard.index;
+        if (shard < 0 || shard >= shardCount) {
+            std::cerr << "Error: " << paths[i] << " has shard index " << shard << " of " << shardCount << "." << std::endl;
+            return 1;
+        }
+        if (manifestOf[shard] >= 0) {
+            std::cerr << "Error: Shard " << shard << " is given twice: " << paths[manifestOf[shard]]
+                      << " and " << paths[i] << "." << std::endl;
+            return 1;
+        }
+        manifestOf[shard] = static_cast<int>(i);
+    }
+    for (int shard = 0; shard < shardCount; ++shard) {
+        if (manifestOf[shard] < 0) {
+            std::cerr << "Error: Shard " << shard << "/" << shardCount << " is missing." << std::endl;
+            return 1;
+        }
+    }
+
+    // Every prefix of the split must be covered exactly once, by the shard it hashes to
+    const NS1D0Config cfg = ns1d0_config(run.n);
+    if (run.n <= 1 || run.n % 2 != 1 || run.depth != shard_depth(cfg, shardCount)) {
+        std::cerr << "Error: The manifests were split at length " << run.depth
+                  << ", not where this version splits n = " << run.n << "." << std::endl;
+        return 1;
+    }
+    std::map<std::vector<int>, int> owner;   // prefix -> manifest index
+    for (const std::vector<int>& prefix : valid_prefixes(cfg, run.depth)) {
+        owner.emplace(prefix, -1);
+    }
+    std::size_t covered = 0;
+    for (std::size_t i = 0; i < manifests.size(); ++i) {
+        for (const std::vector<int>& prefix : manifests[i].prefixes) {
+            auto it = owner.find(prefix);
+            if (it == owner.end()) {
+                std::cerr << "Error: " << paths[i] << " lists a prefix that is not valid." << std::endl;
+                return 1;
+            }
+            if (it->second >= 0) {
+                std::cerr << "Error: A prefix is covered by both " << paths[it->second]
+                          << " and " << paths[i] << "." << std::endl;
+                return 1;
+            }
+            if (shard_of(prefix, shardCount) != manifests[i].shard.index) {
+                std::cerr << "Error: " << paths[i] << " lists a prefix of another shard." << std::endl;
+                return 1;
+            }
+            it->second = static_cast<int>(i);
+            ++covered;
+        }
+    }
+    if (covered != owner.size()) {
+        std::cerr << "Error: " << owner.size() - covered << " of " << owner.size()
+                  << " prefixes are not covered by any shard." << std::endl;
+        return 1;
+    }
+
+    // Check every shard's results against its manifest
+    std::size_t sequences = 0;
+    std::size_t nodes = 0;
+    std::vector<std::string> files(shardCount);
+    for (int shard = 0; shard < shardCount; ++shard) {
+        const int i = manifestOf[shard];
+        const ShardManifest& m = manifests[i];
+        sequences += m.sequences;
+        nodes += m.nodes;
+        if (m.countOnly) continue;
+
+        files[shard] = resolve_output(paths[i], m.output);
+        std::size_t count = 0;
+        std::string error;
+        if (!count_sequences(files[shard], m, count, error)) {
+            std::cerr << "Error: " << error << "." << std::endl;
+            return 1;
+        }
+        if (count != m.sequences) {
+            std::cerr << "Error: " << files[shard] << " holds " << count << " sequences, its manifest says "
+                      << m.sequences << "." << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "NS1D0(" << run.n << "): " << shardCount << " shards cover all " << owner.size()
+              << " prefixes of length " << run.depth << " exactly once" << std::endl;
+    std::cout << "Nodes expanded: " << nodes << std::endl;
+    std::cout << "Valid sequences found: " << sequences << std::endl;
+
+    if (outputPath.empty()) {
+        return 0;
+    }
+    if (run.countOnly) {
+        std::cerr << "Error: The shards only counted sequences; there is nothing to merge." << std::endl;
+        return 1;
+    }
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open output file." << std::endl;
+        return 1;
+    }
+    std::optional<SeqFileWriter> writer;
+    for (int shard = 0; shard < shardCount; ++shard) {
+        std::string error;
+        if (!append_file(files[shard], run.format, out, writer, error)) {
+            std::cerr << "Error: " << error << "." << std::endl;
+            return 1;
+        }
+    }
+    if (writer) {
+        writer->flush();
+    }
+    out.flush();
+    if ((writer && writer->failed()) || !out) {
+        std::cerr << "Error: Could not write " << outputPath << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to: " << outputPath << std::endl;
+    return 0;
+}
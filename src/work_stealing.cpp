@@ -0,0 +1,238 @@
+/**
+ * @file src/work_stealing.cpp
+ *
+ * @brief Implementation of the work-stealing task pool.
+ *
+ * @details Deques are protected by one small mutex each. Contention is low
+ * because the owner only touches its deque when it splits or finishes a task,
+ * and thieves only when they are out of work.
+ */
+
+#include "work_stealing.h"
+
+#include <chrono>
+#include <utility>
+
+/**
+ * @brief Create a pool with one empty deque per worker.
+ *
+ * @param workerCount The number of workers that will call next().
+ */
+WorkStealingPool::WorkStealingPool(int workerCount)
+    : workerCount_(workerCount),
+      queues_(new WorkerQueue[workerCount]),
+      stats_(new PaddedStats[workerCount]) {}
+
+/**
+ * @brief Push a task onto the back of a worker's deque.
+ *
+ * @param worker The worker that owns the deque.
+ * @param task The task to queue.
+ *
+ * @return void
+ *
+ * @details Wakes one waiting worker, if any, so it can steal the task.
+ */
+void WorkStealingPool::push(int worker, SearchTask task) {
+    pending_.fetch_add(1);
+    {
+        WorkerQueue& q = queues_[worker];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.tasks.push_back(std::move(task));
+        q.size.store(q.tasks.size(), std::memory_order_relaxed);
+    }
+    queuedTotal_.fetch_add(1);
+
+    if (idle_.load() > 0) {
+        std::lock_guard<std::mutex> lock(idleMtx_);
+        idleCv_.notify_one();
+    }
+}
+
+/**
+ * @brief Pop the newest task from a worker's own deque.
+ */
+bool WorkStealingPool::try_pop_back(int worker, SearchTask& out) {
+    WorkerQueue& q = queues_[worker];
+    if (q.size.load(std::memory_order_relaxed) == 0) return false;
+
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (q.tasks.empty()) return false;
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    q.size.store(q.tasks.size(), std::memory_order_relaxed);
+    queuedTotal_.fetch_sub(1);
+    return true;
+}
+
+/**
+ * @brief Steal the oldest (shallowest) task from some other worker's deque.
+ */
+bool WorkStealingPool::try_steal(int thief, SearchTask& out) {
+    for (int i = 1; i < workerCount_; ++i) {
+        WorkerQueue& q = queues_[(thief + i) % workerCount_];
+        if (q.size.load(std::memory_order_relaxed) == 0) continue;
+
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.tasks.empty()) continue;
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        q.size.store(q.tasks.size(), std::memory_order_relaxed);
+        queuedTotal_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Take the next task for a worker, waiting for one if necessary.
+ *
+ * @param worker The calling worker.
+ * @param out Receives the task.
+ *
+ * @return true If a task was taken; false once the whole search is finished.
+ *
+ * @details Time spent in here is accounted as idle time for the worker.
+ */
+bool WorkStealingPool::next(int worker, SearchTask& out) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    WorkerStats& st = stats_[worker].stats;
+
+    bool found = false;
+    while (true) {
+        if (!cancelled_.load()) {
+            if (try_pop_back(worker, out)) {
+                found = true;
+                break;
+            }
+            if (try_steal(worker, out)) {
+                ++st.tasksStolen;
+                found = true;
+                break;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(idleMtx_);
+        idle_.fetch_add(1);
+        if (pause_.load()) {
+            pauseCv_.notify_all();   // an idle worker counts as paused
+        }
+        idleCv_.wait(lock, [&] {
+            return (!pause_.load() && queuedTotal_.load() > 0) || pending_.load() == 0 || cancelled_.load();
+        });
+        idle_.fetch_sub(1);
+        if ((queuedTotal_.load() == 0 && pending_.load() == 0) || cancelled_.load()) {
+            ++exited_;
+            pauseCv_.notify_all();
+            break;
+        }
+    }
+
+    if (found) ++st.tasksRun;
+    st.idleSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    return found;
+}
+
+/**
+ * @brief Mark a task as finished.
+ *
+ * @return void
+ *
+ * @details When the last pending task finishes, every waiting worker is woken so it can exit.
+ */
+void WorkStealingPool::task_done() {
+    if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idleMtx_);
+        idleCv_.notify_all();
+    }
+}
+
+/**
+ * @brief Park the calling worker for a checkpoint.
+ *
+ * @param frontier The work the worker has not explored yet, as tasks.
+ *
+ * @return void
+ *
+ * @details The worker keeps its own state; the frontier is only a description of
+ * what is left, for pause() to hand to the checkpoint. The worker continues exactly
+ * where it stopped once resume() is called.
+ */
+void WorkStealingPool::park(std::vector<SearchTask> frontier) {
+    std::unique_lock<std::mutex> lock(idleMtx_);
+    if (!pause_.load()) {
+        return; // the pause already ended
+    }
+
+    for (SearchTask& task : frontier) {
+        parkedFrontier_.push_back(std::move(task));
+    }
+    ++parked_;
+    pauseCv_.notify_all();
+
+    const unsigned epoch = pauseEpoch_;
+    resumeCv_.wait(lock, [&] { return pauseEpoch_ != epoch; });
+}
+
+/**
+ * @brief Stop the world and collect the remaining search as tasks.
+ *
+ * @param frontier Receives the queued tasks and the frontiers of all parked workers.
+ *
+ * @return true If the workers are paused; false if the search finished first.
+ *
+ * @details Waits until every worker is parked, idle or gone. Call resume() after a
+ * successful pause().
+ */
+bool WorkStealingPool::pause(std::vector<SearchTask>& frontier) {
+    std::unique_lock<std::mutex> lock(idleMtx_);
+    pause_.store(true);
+    pauseCv_.wait(lock, [&] {
+        return parked_ + idle_.load() + exited_ == workerCount_;
+    });
+
+    if (pending_.load() == 0) {
+        pause_.store(false);
+        idleCv_.notify_all();
+        return false;
+    }
+
+    frontier = parkedFrontier_;
+    for (int w = 0; w < workerCount_; ++w) {
+        WorkerQueue& q = queues_[w];
+        std::lock_guard<std::mutex> qlock(q.mtx);
+        frontier.insert(frontier.end(), q.tasks.begin(), q.tasks.end());
+    }
+    return true;
+}
+
+/**
+ * @brief End a pause started by pause().
+ *
+ * @return void
+ */
+void WorkStealingPool::resume() {
+    std::lock_guard<std::mutex> lock(idleMtx_);
+    pause_.store(false);
+    parked_ = 0;
+    parkedFrontier_.clear();
+    ++pauseEpoch_;
+    resumeCv_.notify_all();
+    idleCv_.notify_all();
+}
+
+/**
+ * @brief Stop handing out tasks.
+ *
+ * @return void
+ *
+ * @details Idle workers are woken and leave next() with false, as does every later
+ * call. Tasks still queued are dropped; running ones end when their workers see
+ * cancelled().
+ */
+void WorkStealingPool::cancel() {
+    std::lock_guard<std::mutex> lock(idleMtx_);
+    cancelled_.store(true);
+    idleCv_.notify_all();
+}